@@ -0,0 +1,181 @@
+/**
+ * @file axis_dsp.c
+ * @brief 摇杆四轴报告处理内核实现
+ */
+
+#include "axis_dsp.h"
+#include "timestamp.h"
+#include <board.h>
+#include <stdlib.h>
+
+/* ================ 参考实现 ================ */
+
+/* 将int16_t (-32768~32767) 转换为 int8_t (-127~127) */
+int8_t axis_scale_ref(int16_t value)
+{
+    int32_t scaled = ((int32_t)value * 127) / 32768;
+    if (scaled > 127) scaled = 127;
+    if (scaled < -127) scaled = -127;
+    return (int8_t)scaled;
+}
+
+/* 检测轴值是否有显著变化 */
+bool axis_changed_ref(int16_t new_val, int16_t old_val, uint16_t threshold)
+{
+    int32_t diff = (int32_t)new_val - (int32_t)old_val;
+    if (diff < 0) diff = -diff;
+    return diff > threshold;
+}
+
+/* ================ 处理内核 ================ */
+
+#if AXIS_DSP_USE_SIMD
+
+/* 有符号乘积向零截断后右移15位 */
+#define TRUNC_SHR15(p)  (((p) + (((p) >> 31) & 0x7FFF)) >> 15)
+
+/* 缩放一对轴，返回 [X, Y] 两个字节 */
+static inline uint32_t pair_scale(uint32_t v)
+{
+    int32_t px = (int32_t)__SMUAD(v, 0x0000007F);     /* x * 127 */
+    int32_t py = (int32_t)__SMUAD(v, 0x007F0000);     /* y * 127 */
+    uint32_t q;
+
+    q = __PKHBT((uint32_t)TRUNC_SHR15(px), (uint32_t)TRUNC_SHR15(py), 16);
+    q = __SSAT16(q, 8);                                 /* 两路同时饱和到 int8 */
+
+    return (q & 0xFF) | ((q >> 8) & 0xFF00);
+}
+
+/*
+ * 一对轴的变化检测，返回 bit0=X bit1=Y
+ * |d| > thr 等价于 d - (thr+1) >= 0 或 -d - (thr+1) >= 0，只需看两路结果的符号位，
+ * 不依赖GE标志，编译器无法打乱指令顺序
+ */
+static inline uint32_t pair_changed(uint32_t now, uint32_t last, uint32_t thr_pair)
+{
+    uint32_t d = __QSUB16(now, last);   /* 饱和差值，超出范围仍大于阈值 */
+    uint32_t n = __QSUB16(0, d);        /* -d，-32768饱和为32767 */
+    uint32_t m = ~(__QSUB16(d, thr_pair) & __QSUB16(n, thr_pair)) & 0x80008000u;
+
+    return ((m >> 15) & 1) | ((m >> 30) & 2);
+}
+
+#else
+
+/* 无DSP扩展: 逐轴处理 */
+static inline uint32_t pair_scale(uint32_t v)
+{
+    return (uint8_t)axis_scale_ref((int16_t)v) |
+           ((uint32_t)(uint8_t)axis_scale_ref((int16_t)(v >> 16)) << 8);
+}
+
+static inline uint32_t pair_changed(uint32_t now, uint32_t last, uint32_t thr_pair)
+{
+    uint16_t thr = (uint16_t)((thr_pair & 0xFFFF) - 1);
+
+    return (uint32_t)axis_changed_ref((int16_t)now, (int16_t)last, thr) |
+           ((uint32_t)axis_changed_ref((int16_t)(now >> 16), (int16_t)(last >> 16), thr) << 1);
+}
+
+#endif /* AXIS_DSP_USE_SIMD */
+
+/* 处理两对轴 */
+uint32_t axis_dsp_process(const axis_pair_t in[AXIS_DSP_PAIRS],
+                          const axis_pair_t last[AXIS_DSP_PAIRS],
+                          int8_t out[AXIS_DSP_AXES], uint16_t threshold)
+{
+    uint32_t thr_pair = (uint32_t)(threshold + 1) * 0x00010001u;
+    uint32_t mask = 0;
+    uint32_t s;
+
+    for (uint32_t i = 0; i < AXIS_DSP_PAIRS; i++)
+    {
+        s = pair_scale(in[i]);
+        out[i * 2] = (int8_t)s;
+        out[i * 2 + 1] = (int8_t)(s >> 8);
+        mask |= pair_changed(in[i], last[i], thr_pair) << (i * 2);
+    }
+
+    return mask;
+}
+
+/* ================ 调试命令 ================ */
+
+/* 伪随机数 (xorshift32) */
+static uint32_t check_rand(uint32_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+/* 内核与参考实现逐位比对，并比较耗时 */
+static int axis_dsp_check(int argc, char **argv)
+{
+    uint32_t count = (argc > 1) ? (uint32_t)atoi(argv[1]) : 100000;
+    uint32_t seed = 0x12345678;
+    uint32_t errors = 0, cyc_kernel = 0, cyc_ref = 0, t0;
+    axis_pair_t in[AXIS_DSP_PAIRS], last[AXIS_DSP_PAIRS];
+    int8_t out[AXIS_DSP_AXES], ref_out[AXIS_DSP_AXES];
+    uint32_t mask, ref_mask;
+    uint16_t thr;
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        /* 前几组覆盖边界值，其余随机 */
+        if (n == 0)
+        {
+            in[0] = axis_pack(-32768, 32767);
+            in[1] = axis_pack(-1, 1);
+            last[0] = axis_pack(32767, -32768);
+            last[1] = axis_pack(0, 0);
+        }
+        else
+        {
+            in[0] = check_rand(&seed);
+            in[1] = check_rand(&seed);
+            last[0] = (n & 1) ? (in[0] + (check_rand(&seed) & 0x03FF03FF)) : check_rand(&seed);
+            last[1] = (n & 1) ? (in[1] - (check_rand(&seed) & 0x03FF03FF)) : check_rand(&seed);
+        }
+        thr = (uint16_t)(n & 0x3FF);
+
+        t0 = ts_cycles();
+        mask = axis_dsp_process(in, last, out, thr);
+        cyc_kernel += ts_cycles() - t0;
+
+        t0 = ts_cycles();
+        ref_mask = 0;
+        for (uint32_t i = 0; i < AXIS_DSP_AXES; i++)
+        {
+            int16_t v = (int16_t)(in[i / 2] >> ((i & 1) * 16));
+            int16_t l = (int16_t)(last[i / 2] >> ((i & 1) * 16));
+
+            ref_out[i] = axis_scale_ref(v);
+            if (axis_changed_ref(v, l, thr))
+                ref_mask |= 1u << i;
+        }
+        cyc_ref += ts_cycles() - t0;
+
+        if (mask != ref_mask || rt_memcmp(out, ref_out, sizeof(out)) != 0)
+        {
+            if (errors < 4)
+            {
+                rt_kprintf("mismatch: in %08x %08x last %08x %08x thr %d mask %x/%x\n",
+                           in[0], in[1], last[0], last[1], thr, mask, ref_mask);
+            }
+            errors++;
+        }
+    }
+
+    rt_kprintf("%s kernel: %d vectors, %d mismatches\n",
+               AXIS_DSP_USE_SIMD ? "SIMD" : "C", count, errors);
+    if (count)
+    {
+        rt_kprintf("cycles per 4 axes: kernel %d, scalar %d\n", cyc_kernel / count, cyc_ref / count);
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(axis_dsp_check, compare axis kernel against scalar reference);
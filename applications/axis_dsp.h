@@ -0,0 +1,73 @@
+/**
+ * @file axis_dsp.h
+ * @brief 摇杆四轴报告处理内核 (packed Q15)
+ * @details 每个摇杆的X/Y打包为一个32位字，利用Cortex-M33 DSP扩展一次处理两个轴；
+ *          无DSP扩展时使用逐轴C实现，两者结果逐位一致
+ */
+
+#ifndef __AXIS_DSP_H__
+#define __AXIS_DSP_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ================ 配置参数 ================ */
+
+/* 默认按编译目标选择，主机测试可在命令行指定以便用内联函数桩编译SIMD路径 */
+#ifndef AXIS_DSP_USE_SIMD
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define AXIS_DSP_USE_SIMD   1
+#else
+#define AXIS_DSP_USE_SIMD   0
+#endif
+#endif
+
+#define AXIS_DSP_PAIRS      2       /* 左右两个摇杆 */
+#define AXIS_DSP_AXES       (AXIS_DSP_PAIRS * 2)
+
+/* 打包的一对轴: 低16位X，高16位Y (均为Q15) */
+typedef uint32_t axis_pair_t;
+
+/**
+ * @brief 打包一对轴
+ * @param x X轴 (-32768 ~ 32767)
+ * @param y Y轴 (-32768 ~ 32767)
+ * @return 打包值
+ */
+rt_inline axis_pair_t axis_pack(int16_t x, int16_t y)
+{
+    return (uint32_t)(uint16_t)x | ((uint32_t)(uint16_t)y << 16);
+}
+
+/**
+ * @brief 处理两对轴: 缩放饱和到报告范围，并检测相对上次发送值的变化
+ * @param in 当前轴值 [左, 右]
+ * @param last 上次发送的轴值 [左, 右]
+ * @param out 报告轴值 (-127 ~ 127)，顺序为 LX LY RX RY
+ * @param threshold 变化阈值，|差值| 大于此值视为变化 (< 32767)
+ * @return 变化掩码，bit0~3 对应 LX LY RX RY
+ */
+uint32_t axis_dsp_process(const axis_pair_t in[AXIS_DSP_PAIRS],
+                          const axis_pair_t last[AXIS_DSP_PAIRS],
+                          int8_t out[AXIS_DSP_AXES], uint16_t threshold);
+
+/**
+ * @brief 单轴缩放参考实现: int16 (-32768~32767) -> int8 (-127~127)，向零截断
+ */
+int8_t axis_scale_ref(int16_t value);
+
+/**
+ * @brief 单轴变化检测参考实现
+ */
+bool axis_changed_ref(int16_t new_val, int16_t old_val, uint16_t threshold);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AXIS_DSP_H__ */
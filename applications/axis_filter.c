@@ -0,0 +1,205 @@
+/**
+ * @file axis_filter.c
+ * @brief 摇杆轴自适应低通滤波实现
+ * @details 1-Euro滤波:
+ *          dx  = lowpass((x - x_hat) / Te, d_cutoff)
+ *          fc  = min_cutoff + beta * |dx|
+ *          x_hat = lowpass(x, fc)
+ *          其中 alpha = w / (w + 1)，w = 2π·fc·Te，全部为整数运算
+ */
+
+#include "axis_filter.h"
+#include "timestamp.h"
+#include <stdlib.h>
+
+/* ================ 内部定义 ================ */
+
+/* 2π * 65536 / (256 * 1000000) 的Q24表示: fc(Q8 Hz) * Te(us) -> w(Q16) */
+#define W_SCALE_Q24     26986
+
+#define AXIS_FILTER_NUM 4
+
+/* ================ 内部变量 ================ */
+
+static axis_filter_config_t filter_cfg = {
+    .min_cutoff_mhz = AXIS_FILTER_MIN_CUTOFF_MHZ,
+    .beta_mhz = AXIS_FILTER_BETA_MHZ,
+    .d_cutoff_mhz = AXIS_FILTER_D_CUTOFF_MHZ,
+};
+
+/* 由配置换算出的定点参数 */
+static int32_t min_cutoff_q8 = AXIS_FILTER_MIN_CUTOFF_MHZ * 256 / 1000;
+static int32_t d_cutoff_q8 = AXIS_FILTER_D_CUTOFF_MHZ * 256 / 1000;
+static int32_t beta_q16 = AXIS_FILTER_BETA_MHZ * 65536 / 1000;
+
+static axis_filter_state_t filters[AXIS_FILTER_NUM];
+static uint32_t last_update_us = 0;
+
+/* ================ 内部函数 ================ */
+
+/* 截止频率(Q8 Hz)和采样间隔 -> 平滑系数alpha(Q16) */
+static int32_t filter_alpha(int32_t fc_q8, uint32_t dt_us)
+{
+    uint32_t w = (uint32_t)(((uint64_t)fc_q8 * dt_us * W_SCALE_Q24) >> 24);
+
+    return (int32_t)(((uint64_t)w << 16) / (w + 65536));
+}
+
+/* ================ 公共API ================ */
+
+/* 单轴滤波一步 */
+int16_t axis_filter_step(axis_filter_state_t *st, int16_t x, uint32_t dt_us)
+{
+    int32_t x_q8 = (int32_t)x << 8;
+    int32_t speed, fc_q8, alpha;
+    int64_t raw_dx;
+
+    if (!st->init || dt_us == 0)
+    {
+        st->x_q8 = x_q8;
+        st->dx_q8 = 0;
+        st->init = 1;
+        return x;
+    }
+
+    /* 速度估计 (count/ms, Q8)，再做一次固定截止频率的平滑 */
+    raw_dx = (int64_t)(x_q8 - st->x_q8) * 1000 / dt_us;
+    if (raw_dx > INT32_MAX / 2) raw_dx = INT32_MAX / 2;
+    if (raw_dx < -INT32_MAX / 2) raw_dx = -INT32_MAX / 2;
+    st->dx_q8 += (int32_t)(((raw_dx - st->dx_q8) * filter_alpha(d_cutoff_q8, dt_us)) >> 16);
+
+    /* 截止频率随速度升高 */
+    speed = abs(st->dx_q8);
+    fc_q8 = min_cutoff_q8 + (int32_t)(((int64_t)beta_q16 * speed) >> 16);
+    if (fc_q8 > AXIS_FILTER_MAX_CUTOFF_HZ * 256)
+        fc_q8 = AXIS_FILTER_MAX_CUTOFF_HZ * 256;
+
+    alpha = filter_alpha(fc_q8, dt_us);
+    st->x_q8 += (int32_t)(((int64_t)(x_q8 - st->x_q8) * alpha) >> 16);
+
+    return (int16_t)((st->x_q8 + 128) >> 8);
+}
+
+/* 对双摇杆4个轴滤波 */
+void axis_filter_apply(joystick_data_t *left, joystick_data_t *right)
+{
+#if AXIS_FILTER_ENABLE
+    uint32_t now = ts_us();
+    uint32_t dt = now - last_update_us;
+
+    /* 长时间未更新(如空闲休眠)后从当前值重新开始，避免唤醒后拖尾 */
+    if (dt > AXIS_FILTER_RESET_US)
+    {
+        for (uint32_t i = 0; i < AXIS_FILTER_NUM; i++)
+            filters[i].init = 0;
+    }
+    last_update_us = now;
+
+    left->x = axis_filter_step(&filters[0], left->x, dt);
+    left->y = axis_filter_step(&filters[1], left->y, dt);
+    right->x = axis_filter_step(&filters[2], right->x, dt);
+    right->y = axis_filter_step(&filters[3], right->y, dt);
+#endif
+}
+
+/* 设置滤波参数 */
+void axis_filter_set_config(const axis_filter_config_t *cfg)
+{
+    filter_cfg = *cfg;
+    min_cutoff_q8 = (int32_t)(cfg->min_cutoff_mhz * 256 / 1000);
+    d_cutoff_q8 = (int32_t)(cfg->d_cutoff_mhz * 256 / 1000);
+    beta_q16 = (int32_t)(cfg->beta_mhz * 65536 / 1000);
+}
+
+/* 获取当前滤波参数 */
+const axis_filter_config_t *axis_filter_get_config(void)
+{
+    return &filter_cfg;
+}
+
+/* ================ 调试命令 ================ */
+
+#define BENCH_PERIOD_MS  1
+
+/*
+ * 在实际摇杆上评估滤波效果 (独立滤波状态，不影响报告):
+ * 抖动 = 相邻采样平均变化量；延迟 ≈ Σ|输入-输出| / Σ|输入变化| × 采样周期
+ * 先保持摇杆静止测抖动，再来回拨动测延迟
+ */
+static void filter_bench(uint32_t ms)
+{
+    static const char *names[AXIS_FILTER_NUM] = {"LX", "LY", "RX", "RY"};
+    axis_filter_state_t st[AXIS_FILTER_NUM] = {0};
+    int32_t prev_raw[AXIS_FILTER_NUM] = {0}, prev_out[AXIS_FILTER_NUM] = {0};
+    uint64_t d_raw[AXIS_FILTER_NUM] = {0}, d_out[AXIS_FILTER_NUM] = {0}, err[AXIS_FILTER_NUM] = {0};
+    joystick_data_t left, right;
+    uint32_t last = ts_us(), now;
+
+    for (uint32_t n = 0; n <= ms / BENCH_PERIOD_MS; n++)
+    {
+        int32_t raw[AXIS_FILTER_NUM];
+
+        joystick_read(&left, &right);
+        now = ts_us();
+        raw[0] = left.x; raw[1] = left.y; raw[2] = right.x; raw[3] = right.y;
+
+        for (uint32_t i = 0; i < AXIS_FILTER_NUM; i++)
+        {
+            int32_t out = axis_filter_step(&st[i], (int16_t)raw[i], now - last);
+
+            if (n > 0)
+            {
+                d_raw[i] += abs(raw[i] - prev_raw[i]);
+                d_out[i] += abs(out - prev_out[i]);
+                err[i] += abs(raw[i] - out);
+            }
+            prev_raw[i] = raw[i];
+            prev_out[i] = out;
+        }
+        last = now;
+        rt_thread_mdelay(BENCH_PERIOD_MS);
+    }
+
+    for (uint32_t i = 0; i < AXIS_FILTER_NUM; i++)
+    {
+        rt_kprintf("%s: jitter raw %d filtered %d (count/sample), lag ~%d.%d ms\n", names[i],
+                   (uint32_t)(d_raw[i] / ms), (uint32_t)(d_out[i] / ms),
+                   d_raw[i] ? (uint32_t)(err[i] * BENCH_PERIOD_MS / d_raw[i]) : 0,
+                   d_raw[i] ? (uint32_t)(err[i] * BENCH_PERIOD_MS * 10 / d_raw[i] % 10) : 0);
+    }
+}
+
+/* 查看/设置滤波参数，或评估滤波效果 */
+static int axis_filter(int argc, char **argv)
+{
+    axis_filter_config_t cfg = filter_cfg;
+
+    if (argc >= 2 && rt_strcmp(argv[1], "bench") == 0)
+    {
+        int ms = argc > 2 ? atoi(argv[2]) : 3000;
+
+        /* 时长用作除数，非正数或无法解析时拒绝 */
+        if (ms <= 0)
+        {
+            rt_kprintf("invalid duration: %s\n", argv[2]);
+            return -RT_EINVAL;
+        }
+        filter_bench((uint32_t)ms);
+        return 0;
+    }
+
+    if (argc >= 2)
+    {
+        cfg.min_cutoff_mhz = (uint32_t)atoi(argv[1]);
+        if (argc > 2) cfg.beta_mhz = (uint32_t)atoi(argv[2]);
+        if (argc > 3) cfg.d_cutoff_mhz = (uint32_t)atoi(argv[3]);
+        axis_filter_set_config(&cfg);
+    }
+
+    rt_kprintf("min_cutoff %d mHz, beta %d mHz/(count/ms), d_cutoff %d mHz\n",
+               filter_cfg.min_cutoff_mhz, filter_cfg.beta_mhz, filter_cfg.d_cutoff_mhz);
+    rt_kprintf("usage: axis_filter [min_cutoff_mhz [beta_mhz [d_cutoff_mhz]]] | bench [ms]\n");
+
+    return 0;
+}
+MSH_CMD_EXPORT(axis_filter, show or set stick filter or run filter bench);
@@ -0,0 +1,73 @@
+/**
+ * @file axis_filter.h
+ * @brief 摇杆轴自适应低通滤波 (1-Euro 定点实现)
+ * @details 截止频率随摇杆速度升高: 静止时强平滑，快速拨动时几乎无延迟
+ */
+
+#ifndef __AXIS_FILTER_H__
+#define __AXIS_FILTER_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+#include "joystick_app.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ================ 配置参数 ================ */
+
+#define AXIS_FILTER_ENABLE          1       /* 0: 直通，不滤波 */
+#define AXIS_FILTER_MIN_CUTOFF_MHZ  1500    /* 静止时截止频率 (mHz) */
+#define AXIS_FILTER_BETA_MHZ        200     /* 速度系数: 每 1count/ms 提高的截止频率 (mHz) */
+#define AXIS_FILTER_D_CUTOFF_MHZ    1000    /* 速度估计的截止频率 (mHz) */
+#define AXIS_FILTER_MAX_CUTOFF_HZ   500     /* 截止频率上限 */
+#define AXIS_FILTER_RESET_US        100000  /* 两次更新间隔超过此值则重新初始化 */
+
+/* 滤波参数 */
+typedef struct {
+    uint32_t min_cutoff_mhz;
+    uint32_t beta_mhz;
+    uint32_t d_cutoff_mhz;
+} axis_filter_config_t;
+
+/* 单轴滤波状态 */
+typedef struct {
+    int32_t x_q8;       /* 滤波输出 (Q8) */
+    int32_t dx_q8;      /* 平滑后的速度 (count/ms, Q8) */
+    uint8_t init;
+} axis_filter_state_t;
+
+/**
+ * @brief 单轴滤波一步
+ * @param st 滤波状态
+ * @param x 新采样值
+ * @param dt_us 距上次采样的时间
+ * @return 滤波输出
+ */
+int16_t axis_filter_step(axis_filter_state_t *st, int16_t x, uint32_t dt_us);
+
+/**
+ * @brief 对双摇杆4个轴滤波(原地更新x/y)，采样间隔由时间戳测得
+ * @param left 左摇杆
+ * @param right 右摇杆
+ */
+void axis_filter_apply(joystick_data_t *left, joystick_data_t *right);
+
+/**
+ * @brief 设置滤波参数
+ * @param cfg 参数
+ */
+void axis_filter_set_config(const axis_filter_config_t *cfg);
+
+/**
+ * @brief 获取当前滤波参数
+ * @return 参数指针
+ */
+const axis_filter_config_t *axis_filter_get_config(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AXIS_FILTER_H__ */
@@ -0,0 +1,301 @@
+/**
+ * @file capture.c
+ * @brief 摇杆/矩阵原始数据高速采集与导出实现
+ * @details 摇杆帧由DMA半满/全满中断送入，按键由扫描中断送入，
+ *          两者在关中断下追加到同一条记录流，时间顺序与实际采样一致
+ */
+
+#include "capture.h"
+#include "key_app.h"
+#include "joystick_app.h"
+#include "timestamp.h"
+#include <rthw.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ================ 内部定义 ================ */
+
+#define CAPTURE_MAX_MS      60000
+#define CAPTURE_ADC_AXES    4
+#define CAPTURE_ADC_FRAMES  8       /* 单条ADC记录最多帧数 */
+
+enum {
+    CAP_IDLE = 0,
+    CAP_RUNNING,
+    CAP_DONE
+};
+
+/* ================ 内部变量 ================ */
+
+static uint8_t cap_buf[CAPTURE_BUFFER_SIZE];
+static volatile uint32_t cap_used = 0;
+static volatile uint8_t cap_state = CAP_IDLE;
+static uint8_t cap_flags = 0;
+static uint32_t cap_start_us = 0;
+static uint32_t cap_last_us = 0;
+static uint32_t cap_end_us = 0;
+
+static struct rt_timer cap_timer;
+
+/* ================ 内部函数 ================ */
+
+/* 写入小端整数 */
+static void cap_write_u16(uint32_t pos, uint16_t v)
+{
+    cap_buf[pos] = (uint8_t)v;
+    cap_buf[pos + 1] = (uint8_t)(v >> 8);
+}
+
+/* 追加一条记录，可在中断中调用 */
+static void cap_put(uint8_t tag, const void *data, uint32_t len)
+{
+    rt_base_t level;
+    uint32_t now, dt, pos, need;
+
+    level = rt_hw_interrupt_disable();
+
+    if (cap_state != CAP_RUNNING)
+        goto out;
+
+    now = ts_us();
+    dt = now - cap_last_us;
+    need = 3 + len + ((dt > 0xFFFF) ? 7 : 0);
+    pos = cap_used;
+
+    if (pos + need > CAPTURE_BUFFER_SIZE)
+    {
+        cap_flags |= CAPTURE_FLAG_FULL;
+        cap_end_us = now;
+        cap_state = CAP_DONE;
+        goto out;
+    }
+
+    /* 间隔超出16位时先插入一条绝对时间 */
+    if (dt > 0xFFFF)
+    {
+        cap_buf[pos] = CAPTURE_TAG_TIME;
+        cap_write_u16(pos + 1, 0);
+        cap_write_u16(pos + 3, (uint16_t)now);
+        cap_write_u16(pos + 5, (uint16_t)(now >> 16));
+        pos += 7;
+        dt = 0;
+    }
+
+    cap_buf[pos] = tag;
+    cap_write_u16(pos + 1, (uint16_t)dt);
+    memcpy(&cap_buf[pos + 3], data, len);
+
+    cap_used = pos + 3 + len;
+    cap_last_us = now;
+
+out:
+    rt_hw_interrupt_enable(level);
+}
+
+/* 摇杆原始帧钩子 (DMA中断) */
+static void cap_adc_hook(const uint16_t *frames, uint32_t count)
+{
+    uint8_t rec[1 + CAPTURE_ADC_FRAMES * CAPTURE_ADC_AXES * 2];
+
+    if (count > CAPTURE_ADC_FRAMES)
+    {
+        frames += (count - CAPTURE_ADC_FRAMES) * CAPTURE_ADC_AXES;
+        count = CAPTURE_ADC_FRAMES;
+    }
+
+    rec[0] = (uint8_t)count;
+    memcpy(&rec[1], frames, count * CAPTURE_ADC_AXES * 2);   /* 小端CPU，直接复制 */
+    cap_put(CAPTURE_TAG_ADC, rec, 1 + count * CAPTURE_ADC_AXES * 2);
+}
+
+/* 矩阵原始扫描钩子 (扫描中断) */
+static void cap_key_hook(rt_uint16_t raw)
+{
+    cap_put(CAPTURE_TAG_KEY, &raw, sizeof(raw));
+}
+
+/* 结束采集并卸载钩子 */
+static void cap_finish(void *parameter)
+{
+    rt_base_t level;
+
+    (void)parameter;
+
+    level = rt_hw_interrupt_disable();
+    if (cap_state == CAP_RUNNING)
+    {
+        cap_end_us = ts_us();
+        cap_state = CAP_DONE;
+    }
+    rt_hw_interrupt_enable(level);
+
+    key_set_raw_hook(RT_NULL);
+    joystick_set_frame_hook(RT_NULL);
+}
+
+/* ================ 公共API ================ */
+
+/* 开始采集 */
+rt_err_t capture_start(uint32_t duration_ms)
+{
+    rt_tick_t ticks;
+
+    if (cap_state == CAP_RUNNING)
+        return -RT_EBUSY;
+
+    if (duration_ms == 0 || duration_ms > CAPTURE_MAX_MS)
+        return -RT_EINVAL;
+
+    cap_used = 0;
+    cap_flags = 0;
+    cap_start_us = ts_us();
+    cap_last_us = cap_start_us;
+    cap_end_us = cap_start_us;
+    cap_state = CAP_RUNNING;
+
+    key_set_raw_hook(cap_key_hook);
+    joystick_set_frame_hook(cap_adc_hook);
+
+    ticks = rt_tick_from_millisecond(duration_ms);
+    rt_timer_control(&cap_timer, RT_TIMER_CTRL_SET_TIME, &ticks);
+    rt_timer_start(&cap_timer);
+
+    return RT_EOK;
+}
+
+/* 立即停止采集 */
+void capture_stop(void)
+{
+    rt_timer_stop(&cap_timer);
+    cap_finish(RT_NULL);
+}
+
+/* 是否正在采集 */
+bool capture_is_running(void)
+{
+    return cap_state == CAP_RUNNING;
+}
+
+static int capture_init(void)
+{
+    rt_timer_init(&cap_timer, "capture", cap_finish, RT_NULL, 1,
+                  RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_HARD_TIMER);
+    return 0;
+}
+INIT_APP_EXPORT(capture_init);
+
+/* ================ 导出 ================ */
+
+/* 生成导出头部 */
+static void cap_make_header(capture_header_t *hdr)
+{
+    uint32_t sum = 0;
+
+    for (uint32_t i = 0; i < cap_used; i++)
+        sum += cap_buf[i];
+
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = CAPTURE_MAGIC;
+    hdr->version = CAPTURE_VERSION;
+    hdr->header_size = sizeof(capture_header_t);
+    hdr->start_us = cap_start_us;
+    hdr->duration_us = cap_end_us - cap_start_us;
+    hdr->adc_rate_hz = joystick_get_sample_rate();
+    hdr->key_rate_hz = KEY_SCAN_USE_TIMER ? KEY_SCAN_RATE_HZ : 0;
+    hdr->flags = cap_flags;
+    hdr->payload_size = cap_used;
+    hdr->checksum = sum;
+}
+
+/* 以原始二进制写出: 临时关闭控制台的换行转换 */
+static void cap_dump_binary(const capture_header_t *hdr)
+{
+    rt_device_t console = rt_console_get_device();
+    rt_uint16_t flag;
+
+    if (console == RT_NULL)
+        return;
+
+    rt_kprintf("capture: %d bytes binary follow\n", (uint32_t)(sizeof(*hdr) + cap_used));
+
+    flag = console->open_flag;
+    console->open_flag &= ~RT_DEVICE_FLAG_STREAM;
+    rt_device_write(console, 0, hdr, sizeof(*hdr));
+    rt_device_write(console, 0, cap_buf, cap_used);
+    console->open_flag = flag;
+
+    rt_kprintf("\n");
+}
+
+/* 以十六进制文本写出，适合不能接收二进制的终端 */
+static void cap_dump_hex(const capture_header_t *hdr)
+{
+    const uint8_t *h = (const uint8_t *)hdr;
+    uint32_t total = sizeof(*hdr) + cap_used;
+
+    for (uint32_t i = 0; i < total; i++)
+    {
+        rt_kprintf("%02x", i < sizeof(*hdr) ? h[i] : cap_buf[i - sizeof(*hdr)]);
+        if ((i & 31) == 31 || i + 1 == total)
+            rt_kprintf("\n");
+    }
+}
+
+/* ================ 调试命令 ================ */
+
+static int capture(int argc, char **argv)
+{
+    static const char *const state_names[] = {"idle", "running", "done"};
+    capture_header_t hdr;
+
+    if (argc < 2)
+    {
+        rt_kprintf("usage: capture start [ms] | stop | status | dump [hex]\n");
+        return -1;
+    }
+
+    if (rt_strcmp(argv[1], "start") == 0)
+    {
+        uint32_t ms = (argc > 2) ? (uint32_t)atoi(argv[2]) : 1000;
+        rt_err_t ret = capture_start(ms);
+
+        if (ret != RT_EOK)
+        {
+            rt_kprintf("capture: start failed (%d)\n", ret);
+            return -1;
+        }
+        rt_kprintf("capture: recording %d ms\n", ms);
+    }
+    else if (rt_strcmp(argv[1], "stop") == 0)
+    {
+        capture_stop();
+    }
+    else if (rt_strcmp(argv[1], "status") == 0)
+    {
+        rt_kprintf("capture: %s, %d/%d bytes%s\n", state_names[cap_state],
+                   cap_used, CAPTURE_BUFFER_SIZE,
+                   (cap_flags & CAPTURE_FLAG_FULL) ? ", buffer full" : "");
+    }
+    else if (rt_strcmp(argv[1], "dump") == 0)
+    {
+        if (cap_state != CAP_DONE)
+        {
+            rt_kprintf("capture: nothing to dump (%s)\n", state_names[cap_state]);
+            return -1;
+        }
+
+        cap_make_header(&hdr);
+        if (argc > 2 && rt_strcmp(argv[2], "hex") == 0)
+            cap_dump_hex(&hdr);
+        else
+            cap_dump_binary(&hdr);
+    }
+    else
+    {
+        rt_kprintf("unknown option: %s\n", argv[1]);
+        return -1;
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(capture, raw stick/key capture: capture start [ms] | stop | status | dump [hex]);
@@ -0,0 +1,78 @@
+/**
+ * @file capture.h
+ * @brief 摇杆/矩阵原始数据高速采集与导出
+ * @details 以完整采样率把原始ADC帧和矩阵扫描结果记录到预分配RAM缓冲区，
+ *          结束后以紧凑二进制格式通过控制台导出，供主机脚本重建带精确时间的波形
+ *
+ * 导出格式(小端):
+ *   capture_header_t
+ *   记录流，每条记录: tag(1) + dt_us(2, 距上一条记录) + 数据
+ *     CAPTURE_TAG_ADC:  count(1) + count * 4 * uint16 (LX LY RX RY)，
+ *                       时间戳对应最后一帧，前面各帧按 adc_rate_hz 倒推
+ *     CAPTURE_TAG_KEY:  uint16 原始扫描位图 (鬼键屏蔽和消抖之前)
+ *     CAPTURE_TAG_TIME: uint32 绝对时间戳(us)，间隔超过65535us时插入，此时dt_us为0
+ */
+
+#ifndef __CAPTURE_H__
+#define __CAPTURE_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ================ 配置参数 ================ */
+
+#define CAPTURE_BUFFER_SIZE     (32 * 1024)     /* 记录缓冲区大小，2kHz摇杆+1kHz按键约1.4s */
+#define CAPTURE_MAGIC           0x50414347u     /* "GCAP" */
+#define CAPTURE_VERSION         1
+
+/* 记录类型 */
+#define CAPTURE_TAG_ADC         0xA1
+#define CAPTURE_TAG_KEY         0xB1
+#define CAPTURE_TAG_TIME        0xC1
+
+/* 头部标志 */
+#define CAPTURE_FLAG_FULL       0x01            /* 缓冲区写满提前结束 */
+
+/* 导出头部 */
+typedef struct {
+    uint32_t magic;         /* CAPTURE_MAGIC */
+    uint16_t version;       /* CAPTURE_VERSION */
+    uint16_t header_size;   /* sizeof(capture_header_t) */
+    uint32_t start_us;      /* 第一条记录dt_us的参考时间 */
+    uint32_t duration_us;   /* 实际采集时长 */
+    uint32_t adc_rate_hz;   /* 摇杆采样频率 */
+    uint16_t key_rate_hz;   /* 矩阵扫描频率 */
+    uint8_t flags;          /* CAPTURE_FLAG_xxx */
+    uint8_t reserved;
+    uint32_t payload_size;  /* 记录流字节数 */
+    uint32_t checksum;      /* 记录流逐字节累加和 */
+} capture_header_t;
+
+/**
+ * @brief 开始采集
+ * @param duration_ms 采集时长，缓冲区写满时提前结束
+ * @return RT_EOK成功，-RT_EBUSY正在采集
+ */
+rt_err_t capture_start(uint32_t duration_ms);
+
+/**
+ * @brief 立即停止采集
+ */
+void capture_stop(void);
+
+/**
+ * @brief 是否正在采集
+ * @return true正在采集，期间调用方不应让输入进入休眠
+ */
+bool capture_is_running(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAPTURE_H__ */
@@ -0,0 +1,259 @@
+/**
+ * @file dpad.c
+ * @brief 方向键实现
+ * @details 每个轴的SOCD处理是一张32项的表，下标由本次按键(2位)、上次按键(2位)
+ *          和该轴最近按下的方向(1位)组成，表项给出输出的两位和新的最近方向。
+ *          三种处理方式各一张表，切换方式只替换表指针。
+ *          中立方式不修改按键，相反方向同时按下时由hat表输出居中
+ */
+
+#include "dpad.h"
+#include "usb_app.h"
+#include <stdlib.h>
+
+/* ================ 内部定义 ================ */
+
+#define DPAD_SHIFT_NONE     16      /* 未分配的方向移位到原始位图之外，恒为0 */
+
+/* SOCD表项 */
+#define SOCD_OUT_MASK       0x03    /* bit0/1: 输出的两个方向 */
+#define SOCD_RECENT_SHIFT   2       /* bit2: 最近按下的是第二个方向 */
+
+/* 四个方向(bit0上 bit1下 bit2左 bit3右)到hat值 */
+static const uint8_t hat_lut[16] = {
+    GAMEPAD_HAT_CENTER,     GAMEPAD_HAT_UP,         GAMEPAD_HAT_DOWN,       GAMEPAD_HAT_CENTER,
+    GAMEPAD_HAT_LEFT,       GAMEPAD_HAT_UP_LEFT,    GAMEPAD_HAT_DOWN_LEFT,  GAMEPAD_HAT_LEFT,
+    GAMEPAD_HAT_RIGHT,      GAMEPAD_HAT_UP_RIGHT,   GAMEPAD_HAT_DOWN_RIGHT, GAMEPAD_HAT_RIGHT,
+    GAMEPAD_HAT_CENTER,     GAMEPAD_HAT_UP,         GAMEPAD_HAT_DOWN,       GAMEPAD_HAT_CENTER,
+};
+
+static const char *const socd_names[DPAD_SOCD_NUM] = {"neutral", "last", "first"};
+
+/* ================ 内部变量 ================ */
+
+static uint8_t socd_lut[DPAD_SOCD_NUM][32];
+static const uint8_t *volatile socd_table = socd_lut[DPAD_SOCD_DEFAULT];
+static uint8_t socd_mode = DPAD_SOCD_DEFAULT;
+
+static uint8_t dpad_keys[DPAD_DIRS] = {
+    DPAD_KEY_UP_DEFAULT, DPAD_KEY_DOWN_DEFAULT, DPAD_KEY_LEFT_DEFAULT, DPAD_KEY_RIGHT_DEFAULT
+};
+static volatile uint32_t key_shift;     /* 四个方向的移位量，每字节一个，一次写入生效 */
+static volatile uint16_t key_mask;
+
+static uint32_t last_dir = 0;           /* 上次扫描的四个方向 */
+static uint32_t recent = 0;             /* bit0: 上下轴最近按下的是下，bit1: 左右轴最近按下的是右 */
+
+/* ================ 内部函数 ================ */
+
+/* 生成一个SOCD表项，下标: bit0/1 本次两个方向，bit2/3 上次两个方向，bit4 最近方向 */
+static uint8_t socd_entry(uint8_t mode, uint32_t idx)
+{
+    uint32_t a = idx & 1, b = (idx >> 1) & 1;
+    uint32_t new_a = a & ~(idx >> 2) & 1, new_b = b & ~(idx >> 3) & 1;
+    uint32_t second = (idx >> 4) & 1;
+
+    /* 只有一个方向新按下时更新最近方向，同时按下时保持原值 */
+    if (new_a && !new_b)
+        second = 0;
+    else if (new_b && !new_a)
+        second = 1;
+
+    if (a && b)
+    {
+        if (mode == DPAD_SOCD_LAST)
+        {
+            a = !second;
+            b = second;
+        }
+        else if (mode == DPAD_SOCD_FIRST)
+        {
+            a = second;
+            b = !second;
+        }
+    }
+
+    return (uint8_t)(a | (b << 1) | (second << SOCD_RECENT_SHIFT));
+}
+
+/* 按当前按键分配生成移位量和掩码 */
+static void dpad_compile_keys(void)
+{
+    uint32_t shift = 0;
+    uint16_t mask = 0;
+
+    for (uint8_t d = 0; d < DPAD_DIRS; d++)
+    {
+        if (dpad_keys[d] < 16)
+        {
+            shift |= (uint32_t)dpad_keys[d] << (d * 8);
+            mask |= (uint16_t)(1u << dpad_keys[d]);
+        }
+        else
+        {
+            shift |= (uint32_t)DPAD_SHIFT_NONE << (d * 8);
+        }
+    }
+
+    key_shift = shift;
+    key_mask = mask;
+}
+
+/* ================ 公共API ================ */
+
+/* 由原始按键位图计算hat值 */
+uint8_t dpad_apply(uint16_t raw)
+{
+    const uint8_t *t = socd_table;
+    uint32_t shift = key_shift;
+    uint32_t bits = raw;
+    uint32_t dir, v, h;
+
+    dir = ((bits >> (shift & 0xFF)) & 1) |
+          (((bits >> ((shift >> 8) & 0xFF)) & 1) << 1) |
+          (((bits >> ((shift >> 16) & 0xFF)) & 1) << 2) |
+          (((bits >> (shift >> 24)) & 1) << 3);
+
+    /* 两个轴分别查表: 本次 | 上次 << 2 | 最近方向 << 4 */
+    v = t[(dir & 3) | ((last_dir & 3) << 2) | ((recent & 1) << 4)];
+    h = t[((dir >> 2) & 3) | (last_dir & 0xC) | ((recent & 2) << 3)];
+
+    last_dir = dir;
+    recent = (v >> SOCD_RECENT_SHIFT) | ((h >> SOCD_RECENT_SHIFT) << 1);
+
+    return hat_lut[(v & SOCD_OUT_MASK) | ((h & SOCD_OUT_MASK) << 2)];
+}
+
+/* 获取分配给方向键的原始按键位 */
+uint16_t dpad_get_mask(void)
+{
+    return key_mask;
+}
+
+/* 分配四个方向的按键 */
+rt_err_t dpad_set_keys(const uint8_t keys[DPAD_DIRS])
+{
+    for (uint8_t d = 0; d < DPAD_DIRS; d++)
+    {
+        if (keys[d] >= 16 && keys[d] != DPAD_KEY_NONE)
+            return -RT_EINVAL;
+    }
+
+    for (uint8_t d = 0; d < DPAD_DIRS; d++)
+        dpad_keys[d] = keys[d];
+    dpad_compile_keys();
+
+    return RT_EOK;
+}
+
+/* 读取四个方向的按键 */
+void dpad_get_keys(uint8_t keys[DPAD_DIRS])
+{
+    for (uint8_t d = 0; d < DPAD_DIRS; d++)
+        keys[d] = dpad_keys[d];
+}
+
+/* 选择SOCD处理方式 */
+rt_err_t dpad_set_socd(uint8_t mode)
+{
+    if (mode >= DPAD_SOCD_NUM)
+        return -RT_EINVAL;
+
+    socd_mode = mode;
+    socd_table = socd_lut[mode];
+
+    return RT_EOK;
+}
+
+/* 当前SOCD处理方式 */
+uint8_t dpad_get_socd(void)
+{
+    return socd_mode;
+}
+
+static int dpad_init(void)
+{
+    for (uint8_t m = 0; m < DPAD_SOCD_NUM; m++)
+    {
+        for (uint32_t i = 0; i < 32; i++)
+            socd_lut[m][i] = socd_entry(m, i);
+    }
+    dpad_compile_keys();
+
+    return 0;
+}
+INIT_ENV_EXPORT(dpad_init);
+
+/* ================ 调试命令 ================ */
+
+/* 解析按键号: 数字或none */
+static int dpad_parse_key(const char *s, uint8_t *out)
+{
+    if (rt_strcmp(s, "none") == 0)
+        *out = DPAD_KEY_NONE;
+    else if (*s >= '0' && *s <= '9')
+        *out = (uint8_t)atoi(s);
+    else
+        return -1;
+
+    return 0;
+}
+
+static int dpad(int argc, char **argv)
+{
+    static const char *const dir_names[DPAD_DIRS] = {"up", "down", "left", "right"};
+    uint8_t keys[DPAD_DIRS];
+    uint8_t m;
+
+    if (argc == 6 && rt_strcmp(argv[1], "keys") == 0)
+    {
+        for (uint8_t d = 0; d < DPAD_DIRS; d++)
+        {
+            if (dpad_parse_key(argv[2 + d], &keys[d]) != 0)
+                keys[d] = 16;   /* 交给dpad_set_keys报错 */
+        }
+        if (dpad_set_keys(keys) != RT_EOK)
+        {
+            rt_kprintf("invalid key\n");
+            return -1;
+        }
+    }
+    else if (argc == 2 && rt_strcmp(argv[1], "off") == 0)
+    {
+        for (uint8_t d = 0; d < DPAD_DIRS; d++)
+            keys[d] = DPAD_KEY_NONE;
+        dpad_set_keys(keys);
+    }
+    else if (argc == 3 && rt_strcmp(argv[1], "socd") == 0)
+    {
+        for (m = 0; m < DPAD_SOCD_NUM; m++)
+        {
+            if (rt_strcmp(argv[2], socd_names[m]) == 0)
+                break;
+        }
+        if (dpad_set_socd(m) != RT_EOK)
+        {
+            rt_kprintf("socd mode must be neutral, last or first\n");
+            return -1;
+        }
+    }
+    else if (argc != 1)
+    {
+        rt_kprintf("usage: dpad [keys <up> <down> <left> <right> | socd neutral|last|first | off]\n");
+        return -1;
+    }
+
+    dpad_get_keys(keys);
+    rt_kprintf("dpad keys:");
+    for (uint8_t d = 0; d < DPAD_DIRS; d++)
+    {
+        if (keys[d] < 16)
+            rt_kprintf(" %s=%d", dir_names[d], keys[d]);
+        else
+            rt_kprintf(" %s=none", dir_names[d]);
+    }
+    rt_kprintf(", socd %s\n", socd_names[socd_mode]);
+
+    return 0;
+}
+MSH_CMD_EXPORT(dpad, dpad hat keys: dpad [keys <up> <down> <left> <right> | socd neutral|last|first | off]);
@@ -0,0 +1,90 @@
+/**
+ * @file dpad.h
+ * @brief 方向键: 四个矩阵按键合成8向hat
+ * @details 上下、左右两对按键分别做SOCD(相反方向同时按下)处理，
+ *          结果经16项查找表得到hat值。处理过程全部查表，没有分支，
+ *          斜向和反向输入在同一个扫描周期内反映到报告中
+ */
+
+#ifndef __DPAD_H__
+#define __DPAD_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ================ 配置参数 ================ */
+
+#define DPAD_KEY_NONE           0xFF    /* 方向未分配按键 */
+
+/* 默认不分配，矩阵按键保持按钮输出；通过dpad keys命令或配置档启用 */
+#define DPAD_KEY_UP_DEFAULT     DPAD_KEY_NONE
+#define DPAD_KEY_DOWN_DEFAULT   DPAD_KEY_NONE
+#define DPAD_KEY_LEFT_DEFAULT   DPAD_KEY_NONE
+#define DPAD_KEY_RIGHT_DEFAULT  DPAD_KEY_NONE
+#define DPAD_SOCD_DEFAULT       DPAD_SOCD_NEUTRAL
+
+/* 方向 */
+typedef enum {
+    DPAD_UP = 0,
+    DPAD_DOWN,
+    DPAD_LEFT,
+    DPAD_RIGHT,
+    DPAD_DIRS
+} dpad_dir_t;
+
+/* 相反方向同时按下时的处理方式 */
+typedef enum {
+    DPAD_SOCD_NEUTRAL = 0,      /* 两者抵消，该轴居中 */
+    DPAD_SOCD_LAST,             /* 后按下的方向生效 */
+    DPAD_SOCD_FIRST,            /* 先按下的方向保持 */
+    DPAD_SOCD_NUM
+} dpad_socd_t;
+
+/**
+ * @brief 由原始按键位图计算hat值，每个扫描周期调用一次
+ * @param raw 原始按键位图(矩阵bit0-13，摇杆按键bit14/15)
+ * @return GAMEPAD_HAT_xxx
+ */
+uint8_t dpad_apply(uint16_t raw);
+
+/**
+ * @brief 获取分配给方向键的原始按键位，这些按键不再作为按钮输出
+ * @return 原始按键位图
+ */
+uint16_t dpad_get_mask(void);
+
+/**
+ * @brief 分配四个方向的按键
+ * @param keys 按上、下、左、右顺序的原始按键号，DPAD_KEY_NONE表示不分配
+ * @return RT_EOK成功，-RT_EINVAL参数错误
+ */
+rt_err_t dpad_set_keys(const uint8_t keys[DPAD_DIRS]);
+
+/**
+ * @brief 读取四个方向的按键
+ * @param keys 输出按上、下、左、右顺序的原始按键号
+ */
+void dpad_get_keys(uint8_t keys[DPAD_DIRS]);
+
+/**
+ * @brief 选择SOCD处理方式
+ * @param mode dpad_socd_t
+ * @return RT_EOK成功，-RT_EINVAL参数错误
+ */
+rt_err_t dpad_set_socd(uint8_t mode);
+
+/**
+ * @brief 当前SOCD处理方式
+ * @return dpad_socd_t
+ */
+uint8_t dpad_get_socd(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DPAD_H__ */
@@ -0,0 +1,79 @@
+/**
+ * @file flash_store.c
+ * @brief 应用数据flash存储区
+ * @details 通过ROM API擦写片内flash。擦写期间flash不可取指，全程关中断
+ */
+
+#include "flash_store.h"
+#include <rthw.h>
+#include <board.h>
+#include "fsl_romapi.h"
+
+static flash_config_t flash_cfg;
+static bool flash_ready = false;
+static struct rt_mutex flash_lock;
+
+static int flash_store_init(void)
+{
+    if (FLASH_Init(&flash_cfg) != kStatus_Success)
+    {
+        rt_kprintf("flash_store: init failed\n");
+        return -RT_ERROR;
+    }
+
+    rt_mutex_init(&flash_lock, "fstore", RT_IPC_FLAG_PRIO);
+    flash_ready = true;
+
+    return RT_EOK;
+}
+INIT_DEVICE_EXPORT(flash_store_init);
+
+/* 检查地址范围是否在存储区内 */
+static bool flash_store_in_range(uint32_t addr, uint32_t size)
+{
+    return addr >= FLASH_STORE_BASE &&
+           size <= FLASH_STORE_SIZE &&
+           addr - FLASH_STORE_BASE <= FLASH_STORE_SIZE - size;
+}
+
+/* 擦除存储区中的扇区 */
+rt_err_t flash_store_erase(uint32_t addr, uint32_t size)
+{
+    rt_base_t level;
+    status_t status;
+
+    if (!flash_ready)
+        return -RT_ERROR;
+    if (!flash_store_in_range(addr, size) ||
+        (addr % FLASH_STORE_SECTOR_SIZE) != 0 || (size % FLASH_STORE_SECTOR_SIZE) != 0)
+        return -RT_EINVAL;
+
+    rt_mutex_take(&flash_lock, RT_WAITING_FOREVER);
+    level = rt_hw_interrupt_disable();
+    status = FLASH_EraseSector(&flash_cfg, addr, size, kFLASH_ApiEraseKey);
+    rt_hw_interrupt_enable(level);
+    rt_mutex_release(&flash_lock);
+
+    return (status == kStatus_Success) ? RT_EOK : -RT_EIO;
+}
+
+/* 向已擦除的存储区写入数据 */
+rt_err_t flash_store_program(uint32_t addr, const void *data, uint32_t size)
+{
+    rt_base_t level;
+    status_t status;
+
+    if (!flash_ready)
+        return -RT_ERROR;
+    if (data == RT_NULL || !flash_store_in_range(addr, size) ||
+        (addr % FLASH_STORE_PHRASE_SIZE) != 0 || (size % FLASH_STORE_PHRASE_SIZE) != 0)
+        return -RT_EINVAL;
+
+    rt_mutex_take(&flash_lock, RT_WAITING_FOREVER);
+    level = rt_hw_interrupt_disable();
+    status = FLASH_ProgramPhrase(&flash_cfg, addr, (uint8_t *)data, size);
+    rt_hw_interrupt_enable(level);
+    rt_mutex_release(&flash_lock);
+
+    return (status == kStatus_Success) ? RT_EOK : -RT_EIO;
+}
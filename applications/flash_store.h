@@ -0,0 +1,56 @@
+/**
+ * @file flash_store.h
+ * @brief 应用数据flash存储区
+ * @details 片内flash最后64KB从链接脚本中保留出来，专门存放掉电保存的应用数据。
+ *          数据按固定布局写入，运行时直接通过指针从flash读取，无需拷贝和解析
+ */
+
+#ifndef __FLASH_STORE_H__
+#define __FLASH_STORE_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ================ 存储区布局 ================ */
+
+#define FLASH_STORE_BASE         0x000F0000  /* 须与链接脚本中m_text的结束地址一致 */
+#define FLASH_STORE_SIZE         0x00010000  /* 64KB */
+#define FLASH_STORE_SECTOR_SIZE  0x2000      /* 擦除单位 8KB */
+#define FLASH_STORE_PHRASE_SIZE  16          /* 编程单位 128bit */
+
+/* 各模块占用的扇区 */
+#define FLASH_STORE_MACRO_ADDR   (FLASH_STORE_BASE + 0x0000)  /* 输入宏 (扇区0-5，每个槽位两个扇区) */
+#define FLASH_STORE_MACRO_SLOTS  3
+#define FLASH_STORE_MACRO_SLOT_SECTORS 2
+#define FLASH_STORE_PROFILE_ADDR (FLASH_STORE_BASE + 0xC000)  /* 调参配置 (扇区6，所有槽位共用) */
+#define FLASH_STORE_PROFILE_SLOTS 8
+#define FLASH_STORE_CALIB_ADDR   (FLASH_STORE_BASE + 0xE000)  /* 摇杆校准 (最后一个扇区) */
+
+/* ================ 公共API ================ */
+
+/**
+ * @brief 擦除存储区中的扇区
+ * @param addr 起始地址，须按扇区对齐且位于存储区内
+ * @param size 字节数，须为扇区大小的整数倍
+ * @return RT_EOK成功
+ */
+rt_err_t flash_store_erase(uint32_t addr, uint32_t size);
+
+/**
+ * @brief 向已擦除的存储区写入数据
+ * @param addr 起始地址，须按编程单位对齐且位于存储区内
+ * @param data 数据(位于RAM)
+ * @param size 字节数，须为编程单位的整数倍
+ * @return RT_EOK成功
+ */
+rt_err_t flash_store_program(uint32_t addr, const void *data, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FLASH_STORE_H__ */
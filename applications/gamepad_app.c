@@ -8,133 +8,362 @@
 #include "key_app.h"
 #include "joystick_app.h"
 #include "usb_app.h"
+#include "stick_shape.h"
+#include "axis_filter.h"
+#include "axis_dsp.h"
+#include "capture.h"
+#include "remap.h"
+#include "dpad.h"
+#include "macro.h"
+#include "latency.h"
+#include "profile.h"
+#include "usb_sof.h"
+#include "loop_timer.h"
+#include "timestamp.h"
 #include <rtthread.h>
+#include <stdlib.h>
 
-/* ================ 死区配置 ================ */
+/* ================ 全局变量 ================ */
+
+/* 按键事件消费状态 */
+static uint16_t key_buttons = 0;    /* 由事件累积出的按键状态 */
+static uint16_t key_unsent = 0;     /* 本报告中已变化、尚未发送的按键 */
+static uint32_t batch_count = 0;    /* 本报告包含的事件数 */
+static uint32_t batch_sum_us = 0;   /* 本报告包含事件的时间戳之和 */
+static uint32_t batch_oldest_us = 0;
+
+/* 事件延迟统计: 事件时间戳 -> 报告提交USB */
+static uint32_t evt_total = 0;
+static uint64_t evt_latency_sum = 0;
+static uint32_t evt_latency_max = 0;
 
-#define JOYSTICK_DEADZONE     2000   /* 死区阈值 (原始值，约6%) */
-#define AXIS_CHANGE_THRESHOLD 500    /* 轴变化阈值，低于此值不触发更新 */
+static rt_thread_t gamepad_thread = RT_NULL;
+static uint16_t current_buttons = 0;
+static struct rt_semaphore input_wake_sem;  /* 空闲时由按键中断释放 */
+static uint32_t loop_period_us = GAMEPAD_LOOP_PERIOD_US;  /* 自由运行时的循环周期 */
+static volatile bool loop_restart = false;  /* 周期已修改，需要重启节拍 */
+static bool sof_wanted = false;    /* 当前节拍模式是否要求帧同步 */
+static bool sof_sync = false;      /* 正在按USB帧节拍运行 */
+static uint32_t active_us = 0;     /* 最近一次有输入的时间 */
 
-/* ================ 内部函数 ================ */
+/* 连发: 各按钮的按下/松开时长(ms)，在循环节拍上换算为节拍数 */
+static uint16_t turbo_on_ms[16];
+static uint16_t turbo_off_ms[16];
+static uint16_t turbo_mask = 0;            /* 启用连发的按钮 */
+static uint32_t turbo_on_ticks[16];
+static uint32_t turbo_cycle_ticks[16];
+static uint32_t turbo_start[16];           /* 按下时的节拍序号 */
+static uint16_t turbo_held = 0;            /* 上一周期按住的连发按钮 */
+static uint32_t turbo_period_us = 0;       /* 节拍数换算时使用的周期 */
+static volatile bool turbo_dirty = true;   /* 设置已修改，需要重新换算 */
 
-/* 应用死区，消除中心抖动 */
-static int16_t apply_deadzone(int16_t value)
+/* 上一次状态，用于检测变化 */
+static uint16_t last_buttons = 0;   /* 上次发送的按钮(重映射之后) */
+static uint8_t last_hat = GAMEPAD_HAT_CENTER;
+static axis_pair_t last_axes[AXIS_DSP_PAIRS] = {0};   /* 上次发送的轴值(打包) */
+
+/*
+ * 取出按键事件并更新按键状态。
+ * 同一按键在一个报告内只允许变化一次: 遇到尚未发送的按键再次变化时停止，
+ * 剩余事件留给下一个报告，因此短于一个周期的点按也会被完整上报。
+ * 返回是否有已取出但尚未发送的事件: 这些事件即使不改变报告内容(如被屏蔽的按键)
+ * 也须随一次报告发送，否则key_unsent不会清除，该键的下一个事件会阻塞整个队列
+ */
+static bool key_events_apply(void)
 {
-    if (value > -JOYSTICK_DEADZONE && value < JOYSTICK_DEADZONE)
-        return 0;
-    return value;
+    key_event_t evt;
+    uint16_t bit;
+
+    while (key_event_peek(&evt))
+    {
+        bit = (uint16_t)(1u << evt.key);
+        if (key_unsent & bit)
+            break;
+
+        if (evt.pressed)
+            key_buttons |= bit;
+        else
+            key_buttons &= ~bit;
+
+        if (batch_count == 0)
+            batch_oldest_us = evt.time_us;
+        batch_count++;
+        batch_sum_us += evt.time_us;
+        key_unsent |= bit;
+
+        key_event_pop();
+    }
+
+    return key_unsent != 0;
 }
 
-/* 将int16_t (-32768~32767) 转换为 int8_t (-127~127) */
-static int8_t scale_axis(int16_t value)
+/* 报告已提交USB，统计本批事件的延迟 */
+static void key_events_sent(void)
 {
-    int32_t scaled = ((int32_t)value * 127) / 32768;
-    if (scaled > 127) scaled = 127;
-    if (scaled < -127) scaled = -127;
-    return (int8_t)scaled;
+    uint32_t now;
+
+    if (batch_count)
+    {
+        now = ts_us();
+        evt_total += batch_count;
+        evt_latency_sum += (uint32_t)(now * batch_count - batch_sum_us);  /* 模运算下回绕无影响 */
+        if (now - batch_oldest_us > evt_latency_max)
+            evt_latency_max = now - batch_oldest_us;
+    }
+
+    key_unsent = 0;
+    batch_count = 0;
+    batch_sum_us = 0;
 }
 
-/* 检测轴值是否有显著变化 */
-static bool axis_changed(int16_t new_val, int16_t old_val)
+/* 把时长换算为节拍数，四舍五入且至少1拍 */
+static uint32_t turbo_ticks(uint16_t ms, uint32_t period_us)
 {
-    int32_t diff = (int32_t)new_val - (int32_t)old_val;
-    if (diff < 0) diff = -diff;
-    return diff > AXIS_CHANGE_THRESHOLD;
+    uint32_t ticks = ((uint32_t)ms * 1000 + period_us / 2) / period_us;
+
+    return ticks ? ticks : 1;
 }
 
-/* ================ 全局变量 ================ */
+/* 按当前周期重新换算所有按钮 */
+static void turbo_update(uint32_t period_us)
+{
+    turbo_period_us = period_us;
+    turbo_dirty = false;
 
-static rt_thread_t gamepad_thread = RT_NULL;
-static uint16_t current_buttons = 0;
-static bool pending_send = false;  /* 有待发送的报告 */
+    for (uint8_t i = 0; i < 16; i++)
+    {
+        turbo_on_ticks[i] = turbo_ticks(turbo_on_ms[i], period_us);
+        turbo_cycle_ticks[i] = turbo_on_ticks[i] + turbo_ticks(turbo_off_ms[i], period_us);
+    }
+}
 
-/* 上一次状态，用于检测变化 */
-static uint8_t last_key = 0xFF;
-static joystick_data_t last_left = {0};
-static joystick_data_t last_right = {0};
+/*
+ * 连发: 按住期间按 on/off 节拍数交替输出，相位从按下的节拍开始。
+ * 时间基准是节拍序号而不是循环次数，错过的节拍不会拉长周期；
+ * 帧同步时每个节拍对应一个USB帧，翻转沿与主机轮询对齐
+ */
+static uint16_t turbo_apply(uint16_t buttons, uint32_t tick)
+{
+    uint32_t period_us = loop_timer_period();
+    uint16_t held, pressed, bits;
+    uint8_t i;
+
+    if (turbo_mask == 0)
+    {
+        turbo_held = 0;
+        return buttons;
+    }
+
+    if (period_us && (turbo_dirty || period_us != turbo_period_us))
+        turbo_update(period_us);
+
+    held = buttons & turbo_mask;
+    pressed = held & ~turbo_held;
+    turbo_held = held;
+
+    for (bits = held; bits; bits &= bits - 1)
+    {
+        i = (uint8_t)__builtin_ctz(bits);
+        if (pressed & (1u << i))
+            turbo_start[i] = tick;
+        if ((tick - turbo_start[i]) % turbo_cycle_ticks[i] >= turbo_on_ticks[i])
+            buttons &= ~(1u << i);
+    }
+
+    return buttons;
+}
+
+/*
+ * 选择循环节拍: 主机已配置设备时锁定到USB帧，否则按设定周期自由运行。
+ * 只在模式变化或节拍停止后重启定时器，保持相位
+ */
+static void loop_update(void)
+{
+    bool want_sof = GAMEPAD_SOF_SYNC && hid_gamepad_is_configured(GAMEPAD_USB_BUS_ID);
+
+    if (loop_timer_running() && !loop_restart && want_sof == sof_wanted)
+        return;
+
+    loop_restart = false;
+    sof_wanted = want_sof;
+    usb_sof_stop();
+    sof_sync = want_sof && usb_sof_start(GAMEPAD_SOF_LEAD_US) == RT_EOK;
+    if (!sof_sync)
+        loop_timer_start(loop_period_us);
+}
+
+/*
+ * 配置切换后更新输入循环自身的参数: 连发时长和自由运行周期。
+ * 各模块的查找表已由profile_poll替换，周期变化时下一次loop_update重启节拍
+ */
+static void profile_load(const profile_t *prof)
+{
+    for (uint8_t b = 0; b < 16; b++)
+        gamepad_set_turbo(b, prof->turbo_on_ms[b], prof->turbo_off_ms[b]);
+
+    if (prof->loop_period_us != loop_period_us)
+    {
+        loop_period_us = prof->loop_period_us;
+        loop_restart = true;
+    }
+}
 
 /* ================ 线程入口 ================ */
 
 static void gamepad_thread_entry(void *parameter)
 {
     usb_gamepad_report_t *report;
-    uint8_t key_index;
+    uint16_t key_bitmap;
+    uint16_t raw_buttons, buttons;
+    uint8_t hat;
+    macro_frame_t frame;
+    const profile_t *prof;
     joystick_data_t left, right;
-    int16_t left_x, left_y, right_x, right_y;
+    axis_pair_t axes[AXIS_DSP_PAIRS];
+    int8_t axis_out[AXIS_DSP_AXES];
+    uint32_t axis_mask;
+    uint32_t sample_us;
+    bool events_unsent;
     bool state_changed;
     int ret;
 
     rt_kprintf("[GAMEPAD] Thread started\n");
+    active_us = ts_us();
 
     while (1)
     {
-        /* 读取矩阵按键 */
-        key_index = key_read();
-
-        /* 读取双摇杆并应用死区 */
-        joystick_left_read(&left);
-        joystick_right_read(&right);
-        left_x = apply_deadzone(left.x);
-        left_y = apply_deadzone(left.y);
-        right_x = apply_deadzone(right.x);
-        right_y = apply_deadzone(right.y);
-
-        /* 检测是否有显著变化 */
-        state_changed = (key_index != last_key) ||
-                        (left.btn != last_left.btn) || (right.btn != last_right.btn) ||
-                        axis_changed(left_x, apply_deadzone(last_left.x)) ||
-                        axis_changed(left_y, apply_deadzone(last_left.y)) ||
-                        axis_changed(right_x, apply_deadzone(last_right.x)) ||
-                        axis_changed(right_y, apply_deadzone(last_right.y));
-
-        if (state_changed || pending_send)
+        /* 配置切换在两次报告之间整体生效，本周期内只使用同一份配置 */
+        prof = profile_poll();
+        if (prof != RT_NULL)
+            profile_load(prof);
+        prof = profile_get();
+
+        loop_update();
+
+        /* 报告数据年龄从采样开始计算 */
+        sample_us = ts_us();
+        hid_gamepad_set_sample_time(sample_us);
+        LATENCY_MARK(LATENCY_SCAN);
+
+        /* 同步扫描模式下此调用触发一次扫描；定时扫描模式下事件已由中断写入队列 */
+        key_get_state();
+
+        /* 按时间顺序应用按键事件(组合键同时上报，短按不丢失) */
+        events_unsent = key_events_apply();
+        key_bitmap = key_buttons & GAMEPAD_MATRIX_MASK;
+
+        /* 读取双摇杆最新一帧并启动下一帧转换，自适应滤波后应用径向死区和响应曲线 */
+        joystick_read(&left, &right);
+        LATENCY_MARK(LATENCY_ADC);
+        joystick_sample_start();
+        axis_filter_apply(&left, &right);
+        stick_shape_apply(STICK_LEFT, &left);
+        stick_shape_apply(STICK_RIGHT, &right);
+
+        /* 四轴打包处理: 缩放到报告范围并检测变化 */
+        axes[0] = axis_pack(left.x, left.y);
+        axes[1] = axis_pack(right.x, right.y);
+        axis_mask = axis_dsp_process(axes, last_axes, axis_out, prof->change_threshold);
+
+        /*
+         * 原始按键位图: 矩阵按键 bit0-13，摇杆按键 bit14(LS) 和 bit15(RS)。
+         * 分配给方向键的按键合成hat，其余按键经当前层查表映射为报告按钮，组合键同时上报
+         */
+        raw_buttons = key_bitmap;
+        if (left.btn)
+            raw_buttons |= GAMEPAD_BUTTON_LS;
+        if (right.btn)
+            raw_buttons |= GAMEPAD_BUTTON_RS;
+        hat = dpad_apply(raw_buttons);
+        buttons = turbo_apply(remap_apply(raw_buttons & ~dpad_get_mask()), loop_timer_tick());
+
+        /* 检测是否有显著变化，未发送的按键事件(含Fn层键、映射为空的按键)同样触发发送 */
+        state_changed = (buttons != last_buttons) || hat != last_hat || axis_mask != 0 ||
+                        events_unsent;
+
+        /* 本节拍的输出内容，经宏录制/回放后写入报告 */
+        frame.buttons = buttons;
+        frame.axes[0] = axis_out[0];
+        frame.axes[1] = axis_out[1];
+        frame.axes[2] = axis_out[2];
+        frame.axes[3] = axis_out[3];
+        frame.hat = hat;
+        if (macro_process(loop_timer_tick(), &frame))
+            state_changed = true;
+
+        /* 帧同步时每帧都发送，主机每次轮询都拿到本帧采样的数据 */
+        if (state_changed || sof_sync)
         {
-            /* 获取USB报告缓冲区 */
+            /* 获取报告生成缓冲区，USB正在发送的缓冲区不会被改写 */
             report = hid_gamepad_get_report();
 
-            /* 矩阵按键映射到 bit0-13 (14/15保留给摇杆按键) */
-            if (key_index != 0xFF && key_index < 14)
-                current_buttons = (1 << key_index);
-            else
-                current_buttons = 0;
-
-            /* 摇杆按键映射到 bit14(LS) 和 bit15(RS) */
-            if (left.btn)
-                current_buttons |= GAMEPAD_BUTTON_LS;
-            if (right.btn)
-                current_buttons |= GAMEPAD_BUTTON_RS;
+            current_buttons = frame.buttons;
 
             /* 更新报告 */
-            report->buttons = current_buttons;
-            report->left_x = scale_axis(left_x);
-            report->left_y = scale_axis(left_y);
-            report->right_x = scale_axis(right_x);
-            report->right_y = scale_axis(right_y);
+            report->buttons = frame.buttons;
+            report->left_x = frame.axes[0];
+            report->left_y = frame.axes[1];
+            report->right_x = frame.axes[2];
+            report->right_y = frame.axes[3];
             report->left_trigger = 0;
             report->right_trigger = 0;
-            report->hat = GAMEPAD_HAT_CENTER;
+            report->hat = frame.hat;
+            LATENCY_MARK(LATENCY_BUILT);
 
-            /* 发送USB报告 */
+            /*
+             * 发布USB报告: 端点忙时作为最新状态等待发送完成中断续发，无需重试；
+             * 启动传输失败时不保存状态，下个周期重新生成并发布
+             */
             if (hid_gamepad_is_configured(GAMEPAD_USB_BUS_ID))
             {
                 ret = hid_gamepad_send_report(GAMEPAD_USB_BUS_ID, NULL);
                 if (ret == 0)
                 {
-                    /* 发送成功，保存状态 */
-                    pending_send = false;
-                    last_key = key_index;
-                    last_left = left;
-                    last_right = right;
-                }
-                else if (ret == -2)
-                {
-                    /* 设备忙，下次重试 */
-                    pending_send = true;
+                    /* 发布成功，保存状态 */
+                    key_events_sent();
+                    last_buttons = buttons;
+                    last_hat = hat;
+                    last_axes[0] = axes[0];
+                    last_axes[1] = axes[1];
                 }
             }
+            else
+            {
+                /* 未连接主机时无需保留事件 */
+                key_events_sent();
+            }
         }
 
-        rt_thread_mdelay(GAMEPAD_SCAN_INTERVAL_MS);
+        /* 检测是否空闲: 无按键、摇杆按键未按下且摇杆位于死区内，按实际时间计时与循环周期无关 */
+        if (raw_buttons != 0 || left.x != 0 || left.y != 0 || right.x != 0 || right.y != 0)
+            active_us = sample_us;
+
+        /* 原始数据采集期间不休眠，保证采集到完整采样率的静止数据；宏录制和回放期间同样保持节拍 */
+        if (sample_us - active_us >= GAMEPAD_IDLE_TIMEOUT_MS * 1000u && !capture_is_running() && !macro_is_active())
+        {
+            /* 休眠期间停止循环节拍，唤醒后重新选择节拍模式 */
+            usb_sof_stop();
+            loop_timer_stop();
+            sof_sync = false;
+
+            /*
+             * 停止矩阵扫描和摇杆连续采集，由按键中断和ADC窗口比较唤醒；
+             * 摇杆不支持窗口唤醒时退回定时轮询
+             */
+            rt_sem_control(&input_wake_sem, RT_IPC_CMD_RESET, RT_NULL);
+            key_wake_arm(&input_wake_sem);
+            if (joystick_wake_arm(&input_wake_sem) == RT_EOK)
+                rt_sem_take(&input_wake_sem, RT_WAITING_FOREVER);
+            else
+                rt_sem_take(&input_wake_sem, rt_tick_from_millisecond(GAMEPAD_IDLE_POLL_MS));
+            joystick_wake_disarm();
+            key_wake_disarm();
+            active_us = ts_us();
+            continue;  /* 唤醒后立即扫描，不再等待下一个周期 */
+        }
+
+        /* 本周期运行到底，等待下一个节拍；超时周期计入错过次数 */
+        loop_timer_wait(rt_tick_from_millisecond(GAMEPAD_SCAN_INTERVAL_MS));
     }
 }
 
@@ -143,6 +372,8 @@ static void gamepad_thread_entry(void *parameter)
 /* 启动游戏手柄应用 */
 int gamepad_app_start(void)
 {
+    rt_sem_init(&input_wake_sem, "gp_wake", 0, RT_IPC_FLAG_FIFO);
+
     gamepad_thread = rt_thread_create(
         "gamepad",
         gamepad_thread_entry,
@@ -159,7 +390,7 @@ int gamepad_app_start(void)
     }
 
     rt_thread_startup(gamepad_thread);
-    rt_kprintf("[GAMEPAD] Started (interval: %dms)\n", GAMEPAD_SCAN_INTERVAL_MS);
+    rt_kprintf("[GAMEPAD] Started (period: %dus)\n", loop_period_us);
 
     return 0;
 }
@@ -176,3 +407,140 @@ uint16_t gamepad_get_buttons(void)
 {
     return current_buttons;
 }
+
+/* 查看按键事件延迟统计 */
+static int key_latency(int argc, char **argv)
+{
+    rt_kprintf("key events: %d, dropped: %d\n", evt_total, key_event_dropped());
+    if (evt_total)
+    {
+        rt_kprintf("latency(us): avg %d, max %d\n",
+                   (uint32_t)(evt_latency_sum / evt_total), evt_latency_max);
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(key_latency, show key event to USB report latency);
+
+/* 设置按钮连发 */
+rt_err_t gamepad_set_turbo(uint8_t button, uint16_t on_ms, uint16_t off_ms)
+{
+    if (button >= 16)
+        return -RT_EINVAL;
+
+    turbo_on_ms[button] = on_ms;
+    turbo_off_ms[button] = off_ms;
+    turbo_dirty = true;
+    if (on_ms)
+        turbo_mask |= (uint16_t)(1u << button);
+    else
+        turbo_mask &= (uint16_t)~(1u << button);
+
+    return RT_EOK;
+}
+
+/* 读取按钮连发设置 */
+rt_err_t gamepad_get_turbo(uint8_t button, uint16_t *on_ms, uint16_t *off_ms)
+{
+    if (button >= 16)
+        return -RT_EINVAL;
+
+    *on_ms = (turbo_mask & (1u << button)) ? turbo_on_ms[button] : 0;
+    *off_ms = turbo_off_ms[button];
+
+    return RT_EOK;
+}
+
+/* 获取自由运行时的循环周期 */
+uint32_t gamepad_get_loop_period(void)
+{
+    return loop_period_us;
+}
+
+/* 查看或设置连发 */
+static int turbo(int argc, char **argv)
+{
+    uint8_t button;
+    uint16_t on, off;
+    uint32_t period_us;
+
+    if (argc == 2 && rt_strcmp(argv[1], "clear") == 0)
+    {
+        for (button = 0; button < 16; button++)
+            gamepad_set_turbo(button, 0, 0);
+    }
+    else if (argc >= 3)
+    {
+        button = (uint8_t)atoi(argv[1]);
+        if (rt_strcmp(argv[2], "off") == 0)
+        {
+            on = 0;
+            off = 0;
+        }
+        else
+        {
+            on = (uint16_t)atoi(argv[2]);
+            off = (argc > 3) ? (uint16_t)atoi(argv[3]) : on;
+        }
+
+        if ((on && !off) || gamepad_set_turbo(button, on, off) != RT_EOK)
+        {
+            rt_kprintf("invalid turbo setting\n");
+            return -1;
+        }
+    }
+    else if (argc != 1)
+    {
+        rt_kprintf("usage: turbo [clear | <button> <on_ms> [off_ms] | <button> off]\n");
+        return -1;
+    }
+
+    period_us = loop_timer_period();
+    for (button = 0; button < 16; button++)
+    {
+        if (turbo_mask & (1u << button))
+        {
+            rt_kprintf("button %2d: on %d ms, off %d ms", button, turbo_on_ms[button], turbo_off_ms[button]);
+            if (period_us)
+            {
+                rt_kprintf(" -> %d+%d ticks of %d us", turbo_ticks(turbo_on_ms[button], period_us),
+                           turbo_ticks(turbo_off_ms[button], period_us), period_us);
+            }
+            rt_kprintf("\n");
+        }
+    }
+    if (turbo_mask == 0)
+        rt_kprintf("turbo: off\n");
+
+    return 0;
+}
+MSH_CMD_EXPORT(turbo, button rapid fire: turbo [clear | <button> <on_ms> [off_ms] | <button> off]);
+
+/* 查看或设置输入循环周期 */
+static int gamepad_loop(int argc, char **argv)
+{
+    loop_timer_stats_t st;
+    uint32_t period;
+
+    if (argc > 1 && rt_strcmp(argv[1], "reset") != 0)
+    {
+        period = (uint32_t)atoi(argv[1]);
+        if (period < LOOP_TIMER_PERIOD_MIN_US || period > LOOP_TIMER_PERIOD_MAX_US)
+        {
+            rt_kprintf("period must be %d-%d us\n", LOOP_TIMER_PERIOD_MIN_US, LOOP_TIMER_PERIOD_MAX_US);
+            return -1;
+        }
+        loop_period_us = period;
+        loop_restart = true;
+        rt_kprintf("loop period set to %d us%s\n", period, sof_sync ? " (used when not frame synced)" : "");
+        return 0;
+    }
+
+    loop_timer_get_stats(&st, argc > 1);
+    rt_kprintf("loop: %s, period %d us\n", sof_sync ? "usb frame sync" : "free running", st.period_us);
+    rt_kprintf("ticks %d, runs %d, missed %d\n", st.ticks, st.runs, st.missed);
+    rt_kprintf("max(us): wake %d, work %d\n", st.wake_max_us, st.work_max_us);
+
+    return 0;
+}
+MSH_CMD_EXPORT(gamepad_loop, show loop stats or set period: gamepad_loop [period_us | reset]);
@@ -16,14 +16,21 @@ extern "C" {
 
 /* ================ 配置参数 ================ */
 
-#define GAMEPAD_SCAN_INTERVAL_MS  10   /* 按键扫描间隔(ms) */
+#define GAMEPAD_LOOP_PERIOD_US    1000 /* 输入循环周期(us)，与端点轮询间隔一致 */
+#define GAMEPAD_SCAN_INTERVAL_MS  10   /* 等待循环节拍的超时时间(ms) */
 #define GAMEPAD_USB_BUS_ID        0    /* USB总线ID */
+#define GAMEPAD_IDLE_TIMEOUT_MS   2000 /* 无输入超过该时间后进入按键中断唤醒模式(ms) */
+#define GAMEPAD_IDLE_POLL_MS      100  /* 摇杆不支持窗口唤醒时的轮询间隔(ms) */
+#define GAMEPAD_SOF_SYNC          1    /* 1: 已连接主机时按USB帧节拍采样并发送报告 */
+#define GAMEPAD_SOF_LEAD_US       250  /* 帧同步节拍领先主机SOF的时间(us) */
+#define GAMEPAD_AXIS_THRESHOLD    256  /* 默认轴变化阈值，约为报告中1个单位；运行时取自当前配置 */
 
 /* ================ 按键映射定义 ================ */
 
 /**
  * @brief 按键映射表
- * @note 4x4矩阵键盘(0-15)直接映射到手柄按钮(bit0-bit15)
+ * @note 4x4矩阵键盘(0-15)默认直接映射到手柄按钮(bit0-bit15)，
+ *       运行时可用 remap 命令按层重新映射
  *
  * 按键布局示例:
  *     C1    C2    C3    C4
@@ -43,9 +50,11 @@ extern "C" {
 #define KEY_RB     5   /* 对应按键5 - 右肩键 */
 #define KEY_BACK   6   /* 对应按键6 */
 #define KEY_START  7   /* 对应按键7 */
-/* 矩阵按键8-13可自由分配 */
+/* 矩阵按键8-13可自由分配，其中8-11默认作为方向键(上下左右)，可用 dpad 命令重新分配 */
 /* bit14 = 左摇杆按键(LS), bit15 = 右摇杆按键(RS) - 由摇杆硬件控制 */
 
+#define GAMEPAD_MATRIX_MASK  0x3FFF  /* 矩阵按键可用位 bit0-13 */
+
 /* ================ 公共API ================ */
 
 /**
@@ -67,6 +76,31 @@ bool gamepad_is_ready(void);
  */
 uint16_t gamepad_get_buttons(void);
 
+/**
+ * @brief 设置按钮连发
+ * @param button 报告按钮位(0-15，重映射之后)
+ * @param on_ms 每次按下的时长，0表示关闭连发
+ * @param off_ms 每次松开的时长
+ * @return RT_EOK成功，-RT_EINVAL按钮号错误
+ * @note 时长按循环节拍换算，1ms周期下 on=1 off=1 即500Hz；帧同步时翻转沿与USB帧对齐
+ */
+rt_err_t gamepad_set_turbo(uint8_t button, uint16_t on_ms, uint16_t off_ms);
+
+/**
+ * @brief 读取按钮连发设置
+ * @param button 报告按钮位(0-15)
+ * @param on_ms 输出按下时长，0表示未启用
+ * @param off_ms 输出松开时长
+ * @return RT_EOK成功，-RT_EINVAL按钮号错误
+ */
+rt_err_t gamepad_get_turbo(uint8_t button, uint16_t *on_ms, uint16_t *off_ms);
+
+/**
+ * @brief 获取自由运行时的循环周期
+ * @return 周期(us)
+ */
+uint32_t gamepad_get_loop_period(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,48 @@
+/**
+ * @file int_math.h
+ * @brief 热路径和调试命令共用的整数运算
+ */
+
+#ifndef __INT_MATH_H__
+#define __INT_MATH_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 整数平方根(逐位试商，无除法)
+ * @param v 被开方数
+ * @return floor(sqrt(v))
+ */
+rt_inline uint32_t isqrt32(uint32_t v)
+{
+    uint32_t root = 0, bit = 1u << 30;
+
+    while (bit > v)
+        bit >>= 2;
+    while (bit)
+    {
+        if (v >= root + bit)
+        {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return root;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INT_MATH_H__ */
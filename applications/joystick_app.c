@@ -5,9 +5,30 @@
 
 #include "joystick_app.h"
 #include <rtdevice.h>
+#include <board.h>
+#include "fsl_lpadc.h"
+#include "fsl_edma.h"
+#include "fsl_ctimer.h"
+#include "fsl_inputmux.h"
+#include "flash_store.h"
+#include "int_math.h"
+#include "oversample.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
 
 /* ================ 硬件配置 ================ */
 
+/* 采集方式: 1=LPADC命令链+eDMA后台采集, 0=通过RT-Thread ADC设备逐通道读取 */
+#define JOYSTICK_USE_ADC_DMA  1
+
+/* 触发方式: 1=CTIMER经INPUTMUX硬件定时触发(需要ADC_DMA), 0=软件触发 */
+#define JOYSTICK_HW_TRIGGER   1
+
+#if JOYSTICK_HW_TRIGGER && !JOYSTICK_USE_ADC_DMA
+#error "JOYSTICK_HW_TRIGGER requires JOYSTICK_USE_ADC_DMA"
+#endif
+
 /* ADC设备名称 */
 #define ADC_DEV_NAME    "adc0"
 
@@ -26,18 +47,392 @@
 #define ADC_MAX_VALUE    65535        /* 2^16 - 1 */
 #define ADC_MID_VALUE    32768        /* 中心值 */
 
+/* LPADC + eDMA 采集配置 */
+#define JOYSTICK_ADC            ADC0
+#define JOYSTICK_ADC_TRIGGER    0U                            /* 触发源0启动命令链 */
+#define JOYSTICK_DMA            DMA0
+#define JOYSTICK_DMA_CHANNEL    0U
+#define JOYSTICK_DMA_REQUEST    kDma0RequestMuxAdc0FifoRequest
+#define JOYSTICK_RING_FRAMES    8                             /* 环形缓冲帧数 */
+
+/*
+ * 过采样: 每次转换由LPADC硬件平均JOYSTICK_HW_AVERAGE次，
+ * 读取时再对最近JOYSTICK_OVERSAMPLE_FRAMES帧做boxcar平均(见oversample.h)。
+ * 2kHz采样、平均4帧时输出为2ms窗口的平均值
+ */
+#define JOYSTICK_HW_AVERAGE         kLPADC_HardwareAverageCount8
+#define JOYSTICK_OVERSAMPLE_FRAMES  OVERSAMPLE_FRAMES         /* 须小于JOYSTICK_RING_FRAMES */
+
+/* 硬件触发: CTIMER1 MAT0翻转输出 -> INPUTMUX -> ADC0触发源0 */
+#define JOYSTICK_TRIG_CTIMER        CTIMER1
+#define JOYSTICK_TRIG_CTIMER_DIV    kCLOCK_DivCTIMER1
+#define JOYSTICK_TRIG_CTIMER_CLK    kFRO_HF_to_CTIMER1
+#define JOYSTICK_TRIG_CTIMER_FREQ() CLOCK_GetCTimerClkFreq(1U)
+#define JOYSTICK_TRIG_SIGNAL        kINPUTMUX_Ctimer1M0ToAdc0Trigger
+
+#if (defined(FSL_FEATURE_LPADC_FIFO_COUNT) && (FSL_FEATURE_LPADC_FIFO_COUNT == 2))
+#define JOYSTICK_ADC_RESFIFO    ((void *)&JOYSTICK_ADC->RESFIFO[0])
+#define JOYSTICK_ADC_FCTRL      (JOYSTICK_ADC->FCTRL[0])
+#else
+#define JOYSTICK_ADC_RESFIFO    ((void *)&JOYSTICK_ADC->RESFIFO)
+#define JOYSTICK_ADC_FCTRL      (JOYSTICK_ADC->FCTRL)
+#endif
+
+/* 校准参数 */
+#define JOYSTICK_CAL_MAGIC      0x4A43414Cu   /* "JCAL" */
+#define JOYSTICK_CAL_VERSION    1
+#define JOYSTICK_CAL_MARGIN     2             /* 校准时行程两端各内缩2% */
+#define JOYSTICK_CAL_REST_BAND  1200          /* 偏离中心小于此值(原始值)视为静止 */
+#define JOYSTICK_CAL_DRIFT_SHIFT 10           /* 中心漂移跟踪速度: 每次靠近1/1024 */
+#define JOYSTICK_CAL_DRIFT_MAX  800           /* 在线跟踪相对保存值的最大偏移 */
+
+/* 结果字中的命令号，用于校验一帧内4个结果的顺序 */
+#define RESFIFO_CMDSRC(x)       (((x) >> 24) & 0xF)
+
+/* 一帧4个轴，按命令链顺序存放 */
+enum {
+    AXIS_LEFT_X = 0,
+    AXIS_LEFT_Y,
+    AXIS_RIGHT_X,
+    AXIS_RIGHT_Y,
+    AXIS_NUM
+};
+
+/*
+ * flash中的校准记录: 固定布局，启动时直接通过指针读取，长度为编程单位的整数倍
+ */
+typedef struct {
+    uint32_t magic;         /* JOYSTICK_CAL_MAGIC */
+    uint16_t version;       /* JOYSTICK_CAL_VERSION */
+    uint16_t reserved;
+    struct {
+        uint16_t min;
+        uint16_t center;
+        uint16_t max;
+        uint16_t reserved;
+    } axis[AXIS_NUM];
+    uint32_t checksum;      /* 以上字段按32位异或 */
+    uint32_t pad[5];
+} joystick_cal_record_t;
+
+/* 记录长度须为编程单位的整数倍，且不超过校准扇区 */
+typedef char joystick_cal_size_check[(sizeof(joystick_cal_record_t) % FLASH_STORE_PHRASE_SIZE == 0 &&
+                                      sizeof(joystick_cal_record_t) <= FLASH_STORE_SECTOR_SIZE) ? 1 : -1];
+
+/* 热路径使用的定点校准参数 */
+typedef struct {
+    int32_t center_q8;      /* 当前中心值(Q8)，静止时在线跟踪漂移 */
+    int32_t center_ref_q8;  /* 保存的中心值(Q8)，限制漂移范围 */
+    int32_t gain_pos;       /* 正半轴增益(Q16) */
+    int32_t gain_neg;       /* 负半轴增益(Q16) */
+} axis_cal_t;
+
 /* ================ 内部变量 ================ */
 
+static const joystick_cal_record_t *const cal_flash =
+    (const joystick_cal_record_t *)FLASH_STORE_CALIB_ADDR;
+
+static axis_cal_t axis_cal[AXIS_NUM];
+static joystick_cal_record_t cal_pending;   /* 校准结果，保存前暂存于RAM */
+
+#if JOYSTICK_USE_ADC_DMA
+/* 命令链: CMD1 -> CMD2 -> CMD3 -> CMD4，与AXIS_xxx顺序一致 */
+static const uint32_t axis_channels[AXIS_NUM] = {
+    LEFT_X_CHANNEL, LEFT_Y_CHANNEL, RIGHT_X_CHANNEL, RIGHT_Y_CHANNEL
+};
+
+/* DMA按帧写入的环形缓冲区，每次次循环搬运一帧(4个结果字) */
+static volatile uint32_t adc_ring[JOYSTICK_RING_FRAMES][AXIS_NUM];
+static bool adc_dma_ready = false;
+static uint32_t sample_rate_hz = JOYSTICK_SAMPLE_RATE_HZ;
+#else
 static rt_adc_device_t adc_dev = RT_NULL;
+#endif
+
+static volatile joystick_frame_hook_t frame_hook = RT_NULL;  /* 原始帧钩子 */
+static rt_sem_t joy_wake_sem = RT_NULL;     /* 空闲唤醒信号量 */
+static bool joy_wake_armed = false;
+
+/* ================ 校准 ================ */
+
+/* 计算校准记录校验值 */
+static uint32_t cal_checksum(const joystick_cal_record_t *rec)
+{
+    const uint32_t *p = (const uint32_t *)rec;
+    uint32_t sum = 0;
+
+    for (uint32_t i = 0; i < offsetof(joystick_cal_record_t, checksum) / 4; i++)
+        sum ^= p[i];
+
+    return sum;
+}
+
+/* 由min/center/max预先计算定点增益和偏移 */
+static void cal_apply(const joystick_cal_record_t *rec)
+{
+    for (uint32_t i = 0; i < AXIS_NUM; i++)
+    {
+        int32_t min = rec->axis[i].min;
+        int32_t center = rec->axis[i].center;
+        int32_t max = rec->axis[i].max;
+        int32_t pos = max - center;
+        int32_t neg = center - min;
+
+        if (pos < 1) pos = 1;
+        if (neg < 1) neg = 1;
+
+        axis_cal[i].center_q8 = center << 8;
+        axis_cal[i].center_ref_q8 = center << 8;
+        axis_cal[i].gain_pos = (int32_t)((32767LL << 16) / pos);
+        axis_cal[i].gain_neg = (int32_t)((32768LL << 16) / neg);
+    }
+}
+
+/* 未校准时使用满量程，与原先的 adc - 32768 映射一致 */
+static void cal_default(joystick_cal_record_t *rec)
+{
+    memset(rec, 0, sizeof(*rec));
+    rec->magic = JOYSTICK_CAL_MAGIC;
+    rec->version = JOYSTICK_CAL_VERSION;
+    for (uint32_t i = 0; i < AXIS_NUM; i++)
+    {
+        rec->axis[i].min = 0;
+        rec->axis[i].center = ADC_MID_VALUE;
+        rec->axis[i].max = ADC_MAX_VALUE;
+    }
+    rec->checksum = cal_checksum(rec);
+}
+
+/* 启动时加载校准: 直接校验flash中的记录，无效则使用默认值 */
+static bool cal_load(void)
+{
+    joystick_cal_record_t def;
+
+    if (cal_flash->magic == JOYSTICK_CAL_MAGIC &&
+        cal_flash->version == JOYSTICK_CAL_VERSION &&
+        cal_flash->checksum == cal_checksum(cal_flash))
+    {
+        cal_apply(cal_flash);
+        return true;
+    }
+
+    cal_default(&def);
+    cal_apply(&def);
+    return false;
+}
+
+/*
+ * 原始ADC值 -> 有符号轴值 (-32768 ~ 32767)
+ * 热路径只有一次减法、一次乘法和移位；轴静止时缓慢跟踪中心漂移
+ */
+static int16_t axis_calibrate(uint32_t axis, uint32_t adc_val)
+{
+    axis_cal_t *cal = &axis_cal[axis];
+    int32_t diff = (int32_t)(adc_val << 8) - cal->center_q8;
+    int32_t out;
+
+    if (diff > -(JOYSTICK_CAL_REST_BAND << 8) && diff < (JOYSTICK_CAL_REST_BAND << 8))
+    {
+        int32_t center = cal->center_q8 + (diff >> JOYSTICK_CAL_DRIFT_SHIFT);
+        int32_t offset = center - cal->center_ref_q8;
+
+        if (offset > -(JOYSTICK_CAL_DRIFT_MAX << 8) && offset < (JOYSTICK_CAL_DRIFT_MAX << 8))
+            cal->center_q8 = center;
+    }
+
+    diff >>= 8;
+    out = (int32_t)(((int64_t)diff * (diff >= 0 ? cal->gain_pos : cal->gain_neg)) >> 16);
+
+    if (out > 32767) out = 32767;
+    if (out < -32768) out = -32768;
+
+    return (int16_t)out;
+}
 
 /* ================ 初始化 ================ */
 
+#if JOYSTICK_USE_ADC_DMA
+/*
+ * 配置4条命令组成的命令链。window为true时每条命令使能窗口比较:
+ * CVH < CVL 表示"结果在 [CVH, CVL] 之外"为真，仅比较为真的结果写入FIFO
+ */
+static void joystick_adc_commands(bool window)
+{
+    lpadc_conv_command_config_t cmd;
+    int32_t center, low, high;
+
+    for (uint32_t i = 0; i < AXIS_NUM; i++)
+    {
+        LPADC_GetDefaultConvCommandConfig(&cmd);
+        cmd.channelNumber = axis_channels[i];
+        cmd.sampleChannelMode = kLPADC_SampleChannelSingleEndSideA;
+        cmd.conversionResolutionMode = kLPADC_ConversionResolutionHigh;
+        cmd.hardwareAverageMode = JOYSTICK_HW_AVERAGE;
+        cmd.chainedNextCommandNumber = (i + 1 < AXIS_NUM) ? (i + 2) : 0;
+
+        if (window)
+        {
+            center = axis_cal[i].center_q8 >> 8;
+            low = center - JOYSTICK_WAKE_BAND;
+            high = center + JOYSTICK_WAKE_BAND;
+            if (low < 0) low = 0;
+            if (high > ADC_MAX_VALUE) high = ADC_MAX_VALUE;
+
+            cmd.hardwareCompareMode = kLPADC_HardwareCompareStoreOnTrue;
+            cmd.hardwareCompareValueHigh = (uint32_t)low;
+            cmd.hardwareCompareValueLow = (uint32_t)high;
+        }
+
+        LPADC_SetConvCommandConfig(JOYSTICK_ADC, i + 1, &cmd);
+    }
+}
+
+/* 设置FIFO水位: 结果数超过水位时发出DMA请求或中断 */
+static void joystick_adc_watermark(uint32_t watermark)
+{
+    JOYSTICK_ADC_FCTRL = (JOYSTICK_ADC_FCTRL & ~ADC_FCTRL_FWMARK_MASK) | ADC_FCTRL_FWMARK(watermark);
+}
+
+/* 配置LPADC: 4条命令组成一条链，FIFO满4个结果时发出一次DMA请求 */
+static void joystick_adc_setup(void)
+{
+    lpadc_config_t config;
+    lpadc_conv_trigger_config_t trigger;
+
+    LPADC_GetDefaultConfig(&config);
+    config.enableAnalogPreliminary = true;
+    config.referenceVoltageSource = kLPADC_ReferenceVoltageAlt3;
+    config.conversionAverageMode = kLPADC_ConversionAverage128;
+    config.FIFOWatermark = AXIS_NUM - 1;
+    LPADC_Init(JOYSTICK_ADC, &config);
+
+    LPADC_DoOffsetCalibration(JOYSTICK_ADC);
+    LPADC_DoAutoCalibration(JOYSTICK_ADC);
+
+    joystick_adc_commands(false);
+
+    LPADC_GetDefaultConvTriggerConfig(&trigger);
+    trigger.targetCommandId = 1;
+    trigger.enableHardwareTrigger = (JOYSTICK_HW_TRIGGER != 0);
+    LPADC_SetConvTriggerConfig(JOYSTICK_ADC, JOYSTICK_ADC_TRIGGER, &trigger);
+
+    LPADC_EnableFIFOWatermarkDMA(JOYSTICK_ADC, true);
+}
+
+/* 配置eDMA: 每次请求搬运一帧，主循环结束后目的地址回到缓冲区起点，持续运行 */
+static void joystick_dma_setup(void)
+{
+    edma_config_t config;
+    edma_transfer_config_t xfer;
+
+    EDMA_GetDefaultConfig(&config);
+    EDMA_Init(JOYSTICK_DMA, &config);
+
+    EDMA_SetChannelMux(JOYSTICK_DMA, JOYSTICK_DMA_CHANNEL, JOYSTICK_DMA_REQUEST);
+    EDMA_ResetChannel(JOYSTICK_DMA, JOYSTICK_DMA_CHANNEL);
+
+    EDMA_PrepareTransfer(&xfer, JOYSTICK_ADC_RESFIFO, sizeof(uint32_t),
+                         (void *)adc_ring, sizeof(uint32_t),
+                         sizeof(adc_ring[0]), sizeof(adc_ring),
+                         kEDMA_PeripheralToMemory);
+    EDMA_SetTransferConfig(JOYSTICK_DMA, JOYSTICK_DMA_CHANNEL, &xfer, NULL);
+    EDMA_SetMajorOffsetConfig(JOYSTICK_DMA, JOYSTICK_DMA_CHANNEL, 0, -(int32_t)sizeof(adc_ring));
+    EDMA_EnableAutoStopRequest(JOYSTICK_DMA, JOYSTICK_DMA_CHANNEL, false);
+    EDMA_EnableChannelRequest(JOYSTICK_DMA, JOYSTICK_DMA_CHANNEL);
+}
+#endif
+
+#if JOYSTICK_HW_TRIGGER
+/* 配置CTIMER匹配输出翻转，每个上升沿经INPUTMUX启动一次命令链 */
+static rt_err_t joystick_trigger_setup(uint32_t rate_hz)
+{
+    ctimer_config_t config;
+    ctimer_match_config_t match;
+    uint32_t freq;
+
+    CLOCK_SetClockDiv(JOYSTICK_TRIG_CTIMER_DIV, 1u);
+    CLOCK_AttachClk(JOYSTICK_TRIG_CTIMER_CLK);
+    freq = JOYSTICK_TRIG_CTIMER_FREQ();
+
+    /* 翻转输出两次匹配才有一个上升沿 */
+    if (rate_hz == 0 || rate_hz > freq / 4)
+        return -RT_EINVAL;
+
+    INPUTMUX_Init(INPUTMUX0);
+    INPUTMUX_AttachSignal(INPUTMUX0, JOYSTICK_ADC_TRIGGER, JOYSTICK_TRIG_SIGNAL);
+
+    CTIMER_GetDefaultConfig(&config);
+    CTIMER_Init(JOYSTICK_TRIG_CTIMER, &config);
+
+    match.enableCounterReset = true;
+    match.enableCounterStop = false;
+    match.matchValue = freq / (rate_hz * 2) - 1;
+    match.outControl = kCTIMER_Output_Toggle;
+    match.outPinInitState = false;
+    match.enableInterrupt = false;
+    CTIMER_SetupMatch(JOYSTICK_TRIG_CTIMER, kCTIMER_Match_0, &match);
+
+    CTIMER_StartTimer(JOYSTICK_TRIG_CTIMER);
+
+    return RT_EOK;
+}
+#endif
+
+/* 唤醒源触发: 关闭全部唤醒中断并释放信号量 */
+static void joystick_wake_fire(void)
+{
+    rt_pin_irq_enable(LEFT_BTN_PIN, PIN_IRQ_DISABLE);
+    rt_pin_irq_enable(RIGHT_BTN_PIN, PIN_IRQ_DISABLE);
+#if JOYSTICK_HW_TRIGGER
+    LPADC_DisableInterrupts(JOYSTICK_ADC, kLPADC_FIFOWatermarkInterruptEnable);
+#endif
+
+    if (joy_wake_sem != RT_NULL)
+        rt_sem_release(joy_wake_sem);
+}
+
+/* 摇杆按键下降沿中断 */
+static void joystick_btn_irq(void *args)
+{
+    (void)args;
+    joystick_wake_fire();
+}
+
 static int joystick_init(void)
 {
     /* 先配置按键引脚（即使ADC失败，按键也要能用） */
     rt_pin_mode(LEFT_BTN_PIN, PIN_MODE_INPUT_PULLUP);
     rt_pin_mode(RIGHT_BTN_PIN, PIN_MODE_INPUT_PULLUP);
 
+    /* 摇杆按键挂接下降沿中断，默认关闭，仅在唤醒等待模式下使能 */
+    rt_pin_attach_irq(LEFT_BTN_PIN, PIN_IRQ_MODE_FALLING, joystick_btn_irq, RT_NULL);
+    rt_pin_attach_irq(RIGHT_BTN_PIN, PIN_IRQ_MODE_FALLING, joystick_btn_irq, RT_NULL);
+
+    if (cal_load())
+        rt_kprintf("joystick: calibration loaded\n");
+
+#if JOYSTICK_USE_ADC_DMA
+    /* ADC时钟由adc0驱动配置，这里只接管转换命令和结果搬运 */
+    if (rt_device_find(ADC_DEV_NAME) == RT_NULL)
+    {
+        rt_kprintf("joystick: ADC device %s not found (buttons still work)\n", ADC_DEV_NAME);
+        return RT_EOK;
+    }
+
+    joystick_adc_setup();
+    joystick_dma_setup();
+    adc_dma_ready = true;
+
+#if JOYSTICK_HW_TRIGGER
+    joystick_trigger_setup(JOYSTICK_SAMPLE_RATE_HZ);
+    rt_kprintf("joystick: init OK (LPADC chain + eDMA, %dHz hw trigger)\n", JOYSTICK_SAMPLE_RATE_HZ);
+#else
+    /* 启动第一帧 */
+    joystick_sample_start();
+
+    rt_kprintf("joystick: init OK (LPADC chain + eDMA)\n");
+#endif
+#else
     /* 查找ADC设备 */
     adc_dev = (rt_adc_device_t)rt_device_find(ADC_DEV_NAME);
     if (adc_dev == RT_NULL)
@@ -53,12 +448,56 @@ static int joystick_init(void)
     rt_adc_enable(adc_dev, RIGHT_Y_CHANNEL);
 
     rt_kprintf("joystick: init OK\n");
+#endif
     return RT_EOK;
 }
-INIT_DEVICE_EXPORT(joystick_init);
+/* 在adc0驱动初始化之后接管LPADC */
+INIT_ENV_EXPORT(joystick_init);
 
 /* ================ ADC读取 ================ */
 
+#if JOYSTICK_USE_ADC_DMA
+/*
+ * 对最近count帧完整结果求平均(boxcar抽取): 当前主循环剩余次数给出DMA已写完的帧，
+ * 正在写入的帧不会被读取，已完成的帧要等环形缓冲绕一圈才会被覆盖
+ */
+static bool adc_average_frames(uint32_t frame[AXIS_NUM], uint32_t count)
+{
+    uint32_t remaining, index;
+    oversample_t os;
+
+    if (!adc_dma_ready)
+        return false;
+
+    oversample_reset(&os);
+
+    remaining = EDMA_GetRemainingMajorLoopCount(JOYSTICK_DMA, JOYSTICK_DMA_CHANNEL);
+    index = (JOYSTICK_RING_FRAMES - remaining + JOYSTICK_RING_FRAMES - 1) % JOYSTICK_RING_FRAMES;
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        uint32_t i;
+        uint32_t value[AXIS_NUM];
+
+        for (i = 0; i < AXIS_NUM; i++)
+        {
+            uint32_t word = adc_ring[index][i];
+
+            /* 命令号不匹配说明该帧尚未写入或顺序错乱 */
+            if (RESFIFO_CMDSRC(word) != i + 1)
+                break;
+            value[i] = word & ADC_RESFIFO_D_MASK;
+        }
+
+        if (i == AXIS_NUM)
+            oversample_add(&os, value);
+
+        index = (index + JOYSTICK_RING_FRAMES - 1) % JOYSTICK_RING_FRAMES;
+    }
+
+    return oversample_get(&os, frame);
+}
+#else
 static uint32_t adc_read_channel(uint8_t channel)
 {
     if (adc_dev == RT_NULL)
@@ -66,26 +505,94 @@ static uint32_t adc_read_channel(uint8_t channel)
 
     return rt_adc_read(adc_dev, channel);
 }
+#endif
 
-/* 将ADC值转换为有符号轴值 (-32768 ~ 32767) */
-static int16_t adc_to_axis(uint32_t adc_val)
+/* 读取一帧4轴原始值 */
+static void adc_read_frame(uint32_t frame[AXIS_NUM])
 {
-    if (adc_val > ADC_MAX_VALUE)
-        adc_val = ADC_MAX_VALUE;
+#if JOYSTICK_USE_ADC_DMA
+    if (adc_average_frames(frame, JOYSTICK_OVERSAMPLE_FRAMES))
+        return;
 
-    return (int16_t)(adc_val - ADC_MID_VALUE);
+    for (uint32_t i = 0; i < AXIS_NUM; i++)
+        frame[i] = ADC_MID_VALUE;
+#else
+    frame[AXIS_LEFT_X] = adc_read_channel(LEFT_X_CHANNEL);
+    frame[AXIS_LEFT_Y] = adc_read_channel(LEFT_Y_CHANNEL);
+    frame[AXIS_RIGHT_X] = adc_read_channel(RIGHT_X_CHANNEL);
+    frame[AXIS_RIGHT_Y] = adc_read_channel(RIGHT_Y_CHANNEL);
+#endif
 }
 
 /* ================ 公共API ================ */
 
+/* 启动一次4通道命令链转换 */
+void joystick_sample_start(void)
+{
+    /* 硬件定时触发时采样节奏由CTIMER决定，无需软件触发 */
+#if JOYSTICK_USE_ADC_DMA && !JOYSTICK_HW_TRIGGER
+    if (adc_dma_ready)
+        LPADC_DoSoftwareTrigger(JOYSTICK_ADC, 1U << JOYSTICK_ADC_TRIGGER);
+#endif
+}
+
+/* 设置硬件定时采样频率 */
+rt_err_t joystick_set_sample_rate(uint32_t rate_hz)
+{
+#if JOYSTICK_HW_TRIGGER
+    if (!adc_dma_ready)
+        return -RT_ERROR;
+
+    if (joy_wake_armed)
+        return -RT_EBUSY;
+
+    CTIMER_StopTimer(JOYSTICK_TRIG_CTIMER);
+    if (joystick_trigger_setup(rate_hz) != RT_EOK)
+    {
+        joystick_trigger_setup(sample_rate_hz);
+        return -RT_EINVAL;
+    }
+
+    sample_rate_hz = rate_hz;
+    return RT_EOK;
+#else
+    (void)rate_hz;
+    return -RT_ENOSYS;
+#endif
+}
+
+/* 同时读取双摇杆数据(同一帧采样) */
+rt_err_t joystick_read(joystick_data_t *left, joystick_data_t *right)
+{
+    uint32_t frame[AXIS_NUM];
+
+    if (left == RT_NULL || right == RT_NULL)
+        return -RT_EINVAL;
+
+    adc_read_frame(frame);
+
+    left->x = axis_calibrate(AXIS_LEFT_X, frame[AXIS_LEFT_X]);
+    left->y = axis_calibrate(AXIS_LEFT_Y, frame[AXIS_LEFT_Y]);
+    left->btn = (rt_pin_read(LEFT_BTN_PIN) == PIN_LOW);
+    right->x = axis_calibrate(AXIS_RIGHT_X, frame[AXIS_RIGHT_X]);
+    right->y = axis_calibrate(AXIS_RIGHT_Y, frame[AXIS_RIGHT_Y]);
+    right->btn = (rt_pin_read(RIGHT_BTN_PIN) == PIN_LOW);
+
+    return RT_EOK;
+}
+
 /* 读取左摇杆数据 */
 rt_err_t joystick_left_read(joystick_data_t *data)
 {
+    uint32_t frame[AXIS_NUM];
+
     if (data == RT_NULL)
         return -RT_EINVAL;
 
-    data->x = adc_to_axis(adc_read_channel(LEFT_X_CHANNEL));
-    data->y = adc_to_axis(adc_read_channel(LEFT_Y_CHANNEL));
+    adc_read_frame(frame);
+
+    data->x = axis_calibrate(AXIS_LEFT_X, frame[AXIS_LEFT_X]);
+    data->y = axis_calibrate(AXIS_LEFT_Y, frame[AXIS_LEFT_Y]);
     data->btn = (rt_pin_read(LEFT_BTN_PIN) == PIN_LOW);
 
     return RT_EOK;
@@ -94,11 +601,15 @@ rt_err_t joystick_left_read(joystick_data_t *data)
 /* 读取右摇杆数据 */
 rt_err_t joystick_right_read(joystick_data_t *data)
 {
+    uint32_t frame[AXIS_NUM];
+
     if (data == RT_NULL)
         return -RT_EINVAL;
 
-    data->x = adc_to_axis(adc_read_channel(RIGHT_X_CHANNEL));
-    data->y = adc_to_axis(adc_read_channel(RIGHT_Y_CHANNEL));
+    adc_read_frame(frame);
+
+    data->x = axis_calibrate(AXIS_RIGHT_X, frame[AXIS_RIGHT_X]);
+    data->y = axis_calibrate(AXIS_RIGHT_Y, frame[AXIS_RIGHT_Y]);
     data->btn = (rt_pin_read(RIGHT_BTN_PIN) == PIN_LOW);
 
     return RT_EOK;
@@ -108,8 +619,411 @@ rt_err_t joystick_right_read(joystick_data_t *data)
 void joystick_read_raw(uint32_t *left_x, uint32_t *left_y,
                        uint32_t *right_x, uint32_t *right_y)
 {
-    if (left_x)  *left_x  = adc_read_channel(LEFT_X_CHANNEL);
-    if (left_y)  *left_y  = adc_read_channel(LEFT_Y_CHANNEL);
-    if (right_x) *right_x = adc_read_channel(RIGHT_X_CHANNEL);
-    if (right_y) *right_y = adc_read_channel(RIGHT_Y_CHANNEL);
+    uint32_t frame[AXIS_NUM];
+
+    adc_read_frame(frame);
+
+    if (left_x)  *left_x  = frame[AXIS_LEFT_X];
+    if (left_y)  *left_y  = frame[AXIS_LEFT_Y];
+    if (right_x) *right_x = frame[AXIS_RIGHT_X];
+    if (right_y) *right_y = frame[AXIS_RIGHT_Y];
+}
+
+/* 获取当前硬件定时采样频率 */
+uint32_t joystick_get_sample_rate(void)
+{
+#if JOYSTICK_HW_TRIGGER
+    return sample_rate_hz;
+#else
+    return 0;
+#endif
+}
+
+/* ================ 原始帧钩子 ================ */
+
+#if JOYSTICK_USE_ADC_DMA
+/* 环形缓冲区半满/全满中断: 把刚写完的半个缓冲区交给钩子 */
+void DMA_CH0_IRQHandler(void)
+{
+    uint16_t frames[JOYSTICK_RING_FRAMES / 2][AXIS_NUM];
+    joystick_frame_hook_t hook = frame_hook;
+    uint32_t first;
+
+    rt_interrupt_enter();
+
+    EDMA_ClearChannelStatusFlags(JOYSTICK_DMA, JOYSTICK_DMA_CHANNEL, kEDMA_InterruptFlag);
+
+    /* 半满时剩余次数为一半，全满后重新装载为整圈 */
+    first = (EDMA_GetRemainingMajorLoopCount(JOYSTICK_DMA, JOYSTICK_DMA_CHANNEL) > JOYSTICK_RING_FRAMES / 2)
+            ? JOYSTICK_RING_FRAMES / 2 : 0;
+
+    if (hook != RT_NULL)
+    {
+        for (uint32_t f = 0; f < JOYSTICK_RING_FRAMES / 2; f++)
+        {
+            for (uint32_t i = 0; i < AXIS_NUM; i++)
+                frames[f][i] = (uint16_t)(adc_ring[first + f][i] & ADC_RESFIFO_D_MASK);
+        }
+        hook(&frames[0][0], JOYSTICK_RING_FRAMES / 2);
+    }
+
+    rt_interrupt_leave();
+}
+#endif
+
+/* 设置原始帧钩子 */
+rt_err_t joystick_set_frame_hook(joystick_frame_hook_t hook)
+{
+#if JOYSTICK_USE_ADC_DMA
+    if (!adc_dma_ready)
+        return -RT_ERROR;
+
+    frame_hook = hook;
+    if (hook != RT_NULL)
+    {
+        EDMA_ClearChannelStatusFlags(JOYSTICK_DMA, JOYSTICK_DMA_CHANNEL, kEDMA_InterruptFlag);
+        EDMA_EnableChannelInterrupts(JOYSTICK_DMA, JOYSTICK_DMA_CHANNEL,
+                                     kEDMA_HalfInterruptEnable | kEDMA_MajorInterruptEnable);
+        EnableIRQ(DMA_CH0_IRQn);
+    }
+    else
+    {
+        DisableIRQ(DMA_CH0_IRQn);
+        EDMA_DisableChannelInterrupts(JOYSTICK_DMA, JOYSTICK_DMA_CHANNEL,
+                                      kEDMA_HalfInterruptEnable | kEDMA_MajorInterruptEnable);
+    }
+
+    return RT_EOK;
+#else
+    (void)hook;
+    return -RT_ENOSYS;
+#endif
+}
+
+/* ================ 空闲唤醒 ================ */
+
+#if JOYSTICK_HW_TRIGGER
+/* 窗口比较为真的结果写入FIFO即触发: 任一轴离开中心窗口 */
+void ADC0_IRQHandler(void)
+{
+    rt_interrupt_enter();
+
+    LPADC_DoResetFIFO(JOYSTICK_ADC);
+    joystick_wake_fire();
+
+    rt_interrupt_leave();
+}
+#endif
+
+/* 进入空闲唤醒模式 */
+rt_err_t joystick_wake_arm(rt_sem_t wake_sem)
+{
+#if JOYSTICK_HW_TRIGGER
+    if (wake_sem == RT_NULL)
+        return -RT_EINVAL;
+    if (!adc_dma_ready)
+        return -RT_ENOSYS;
+
+    joy_wake_sem = wake_sem;
+    joy_wake_armed = true;
+
+    /* 停止连续采集: 触发、DMA请求 */
+    CTIMER_StopTimer(JOYSTICK_TRIG_CTIMER);
+    EDMA_DisableChannelRequest(JOYSTICK_DMA, JOYSTICK_DMA_CHANNEL);
+    LPADC_EnableFIFOWatermarkDMA(JOYSTICK_ADC, false);
+
+    /* 命令链改为窗口比较，FIFO中有一个结果即中断 */
+    joystick_adc_commands(true);
+    joystick_adc_watermark(0);
+    LPADC_DoResetFIFO(JOYSTICK_ADC);
+    LPADC_EnableInterrupts(JOYSTICK_ADC, kLPADC_FIFOWatermarkInterruptEnable);
+    EnableIRQ(ADC0_IRQn);
+
+    rt_pin_irq_enable(LEFT_BTN_PIN, PIN_IRQ_ENABLE);
+    rt_pin_irq_enable(RIGHT_BTN_PIN, PIN_IRQ_ENABLE);
+
+    /* 以低频率继续触发命令链，由硬件比较，CPU不参与 */
+    joystick_trigger_setup(JOYSTICK_WAKE_RATE_HZ);
+
+    /* 使能中断前已按下的按键不会再产生下降沿，这里补一次检查 */
+    if (rt_pin_read(LEFT_BTN_PIN) == PIN_LOW || rt_pin_read(RIGHT_BTN_PIN) == PIN_LOW)
+        joystick_wake_fire();
+
+    return RT_EOK;
+#else
+    (void)wake_sem;
+    return -RT_ENOSYS;
+#endif
+}
+
+/* 退出空闲唤醒模式 */
+void joystick_wake_disarm(void)
+{
+#if JOYSTICK_HW_TRIGGER
+    if (!joy_wake_armed)
+        return;
+
+    rt_pin_irq_enable(LEFT_BTN_PIN, PIN_IRQ_DISABLE);
+    rt_pin_irq_enable(RIGHT_BTN_PIN, PIN_IRQ_DISABLE);
+    LPADC_DisableInterrupts(JOYSTICK_ADC, kLPADC_FIFOWatermarkInterruptEnable);
+    DisableIRQ(ADC0_IRQn);
+    joy_wake_sem = RT_NULL;
+
+    /* 恢复命令链和按帧DMA搬运，FIFO清空后重新从帧边界开始 */
+    CTIMER_StopTimer(JOYSTICK_TRIG_CTIMER);
+    joystick_adc_commands(false);
+    joystick_adc_watermark(AXIS_NUM - 1);
+    LPADC_DoResetFIFO(JOYSTICK_ADC);
+    LPADC_EnableFIFOWatermarkDMA(JOYSTICK_ADC, true);
+    EDMA_EnableChannelRequest(JOYSTICK_DMA, JOYSTICK_DMA_CHANNEL);
+
+    joystick_trigger_setup(sample_rate_hz);
+    joy_wake_armed = false;
+#endif
+}
+
+/* ================ 调试命令 ================ */
+
+/* 设置摇杆硬件采样频率 */
+static int joy_rate(int argc, char **argv)
+{
+    uint32_t rate;
+
+    if (argc < 2)
+    {
+        rt_kprintf("usage: joy_rate <hz>\n");
+        return -1;
+    }
+
+    rate = (uint32_t)atoi(argv[1]);
+    if (joystick_set_sample_rate(rate) != RT_EOK)
+    {
+        rt_kprintf("joy_rate: failed to set %d Hz\n", rate);
+        return -1;
+    }
+
+    rt_kprintf("joystick sample rate: %d Hz\n", rate);
+    return 0;
+}
+MSH_CMD_EXPORT(joy_rate, set joystick ADC sample rate: joy_rate <hz>);
+
+#if JOYSTICK_USE_ADC_DMA
+#define NOISE_SAMPLES_MIN   16
+#define NOISE_SAMPLES_MAX   10000   /* 每点约3ms，最长约30s */
+
+/* Welford在线方差: 不保存样本，也不会像平方和那样溢出 */
+typedef struct {
+    uint32_t n;
+    double mean;
+    double m2;
+} noise_stat_t;
+
+static void noise_stat_add(noise_stat_t *st, uint32_t x)
+{
+    double d = (double)x - st->mean;
+
+    st->n++;
+    st->mean += d / st->n;
+    st->m2 += d * ((double)x - st->mean);
+}
+
+/*
+ * 测量摇杆静止时的噪声: 同时记录单帧值和过采样值，
+ * 输出各轴标准差及过采样带来的噪声改善(标准差之比)
+ */
+static int joy_noise(int argc, char **argv)
+{
+    static const char *names[AXIS_NUM] = {"LX", "LY", "RX", "RY"};
+    uint32_t samples = 256;
+    uint32_t single[AXIS_NUM], filtered[AXIS_NUM];
+    noise_stat_t st1[AXIS_NUM] = {0}, st2[AXIS_NUM] = {0};
+
+    if (argc > 1)
+    {
+        int n = atoi(argv[1]);
+
+        if (n < NOISE_SAMPLES_MIN)
+            n = NOISE_SAMPLES_MIN;
+        if (n > NOISE_SAMPLES_MAX)
+            n = NOISE_SAMPLES_MAX;
+        samples = (uint32_t)n;
+    }
+
+    rt_kprintf("keep sticks at rest, sampling %d points...\n", samples);
+
+    for (uint32_t n = 0; n < samples; n++)
+    {
+        rt_thread_mdelay(JOYSTICK_OVERSAMPLE_FRAMES * 1000 / JOYSTICK_SAMPLE_RATE_HZ + 1);
+
+        if (!adc_average_frames(single, 1) ||
+            !adc_average_frames(filtered, JOYSTICK_OVERSAMPLE_FRAMES))
+        {
+            rt_kprintf("joy_noise: ADC not running\n");
+            return -1;
+        }
+
+        for (uint32_t i = 0; i < AXIS_NUM; i++)
+        {
+            noise_stat_add(&st1[i], single[i]);
+            noise_stat_add(&st2[i], filtered[i]);
+        }
+    }
+
+    for (uint32_t i = 0; i < AXIS_NUM; i++)
+    {
+        uint32_t std1 = isqrt32((uint32_t)(st1[i].m2 / samples));
+        uint32_t std2 = isqrt32((uint32_t)(st2[i].m2 / samples));
+
+        rt_kprintf("%s: single std %d, oversampled std %d, gain x%d.%02d\n",
+                   names[i], std1, std2,
+                   std2 ? std1 / std2 : 0, std2 ? (std1 * 100 / std2) % 100 : 0);
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(joy_noise, measure stick noise before/after oversampling: joy_noise [samples]);
+#endif
+
+/* ================ 校准命令 ================ */
+
+#define CAL_CENTER_SAMPLES  64
+#define CAL_SWEEP_MS        5
+
+/* 打印校准记录 */
+static void cal_print(const joystick_cal_record_t *rec)
+{
+    static const char *names[AXIS_NUM] = {"LX", "LY", "RX", "RY"};
+
+    for (uint32_t i = 0; i < AXIS_NUM; i++)
+    {
+        rt_kprintf("  %s: min %5d center %5d max %5d (tracked center %5d)\n", names[i],
+                   rec->axis[i].min, rec->axis[i].center, rec->axis[i].max,
+                   axis_cal[i].center_q8 >> 8);
+    }
+}
+
+/* 采集中心值，再在给定时间内采集行程极值 */
+static int cal_run(uint32_t seconds)
+{
+    uint32_t frame[AXIS_NUM];
+    uint32_t sum[AXIS_NUM] = {0};
+    uint32_t min[AXIS_NUM], max[AXIS_NUM];
+
+    rt_kprintf("release both sticks...\n");
+    rt_thread_mdelay(1000);
+
+    for (uint32_t n = 0; n < CAL_CENTER_SAMPLES; n++)
+    {
+        adc_read_frame(frame);
+        for (uint32_t i = 0; i < AXIS_NUM; i++)
+            sum[i] += frame[i];
+        rt_thread_mdelay(CAL_SWEEP_MS);
+    }
+
+    for (uint32_t i = 0; i < AXIS_NUM; i++)
+    {
+        min[i] = max[i] = sum[i] / CAL_CENTER_SAMPLES;
+    }
+
+    rt_kprintf("rotate both sticks to every edge for %d s...\n", seconds);
+    for (uint32_t n = 0; n < seconds * 1000 / CAL_SWEEP_MS; n++)
+    {
+        adc_read_frame(frame);
+        for (uint32_t i = 0; i < AXIS_NUM; i++)
+        {
+            if (frame[i] < min[i]) min[i] = frame[i];
+            if (frame[i] > max[i]) max[i] = frame[i];
+        }
+        rt_thread_mdelay(CAL_SWEEP_MS);
+    }
+
+    memset(&cal_pending, 0, sizeof(cal_pending));
+    cal_pending.magic = JOYSTICK_CAL_MAGIC;
+    cal_pending.version = JOYSTICK_CAL_VERSION;
+    for (uint32_t i = 0; i < AXIS_NUM; i++)
+    {
+        uint32_t center = sum[i] / CAL_CENTER_SAMPLES;
+
+        /* 两端内缩，保证实际能推到满量程 */
+        cal_pending.axis[i].min = (uint16_t)(min[i] + (center - min[i]) * JOYSTICK_CAL_MARGIN / 100);
+        cal_pending.axis[i].center = (uint16_t)center;
+        cal_pending.axis[i].max = (uint16_t)(max[i] - (max[i] - center) * JOYSTICK_CAL_MARGIN / 100);
+    }
+    cal_pending.checksum = cal_checksum(&cal_pending);
+
+    cal_apply(&cal_pending);
+    rt_kprintf("calibration applied (not saved yet, run 'joy_cal save'):\n");
+    cal_print(&cal_pending);
+
+    return 0;
+}
+
+/* 保存当前校准到flash */
+static int cal_save(void)
+{
+    rt_err_t ret;
+
+    if (cal_pending.magic != JOYSTICK_CAL_MAGIC)
+    {
+        rt_kprintf("nothing to save, run 'joy_cal run' first\n");
+        return -1;
+    }
+
+    ret = flash_store_erase(FLASH_STORE_CALIB_ADDR, FLASH_STORE_SECTOR_SIZE);
+    if (ret == RT_EOK)
+        ret = flash_store_program(FLASH_STORE_CALIB_ADDR, &cal_pending, sizeof(cal_pending));
+
+    rt_kprintf("calibration save %s\n", ret == RT_EOK ? "OK" : "failed");
+    return ret == RT_EOK ? 0 : -1;
+}
+
+/* 摇杆校准命令 */
+static int joy_cal(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        rt_kprintf("usage: joy_cal run [seconds] | save | show | reset\n");
+        return -1;
+    }
+
+    if (rt_strcmp(argv[1], "run") == 0)
+    {
+        return cal_run(argc > 2 ? (uint32_t)atoi(argv[2]) : 5);
+    }
+    else if (rt_strcmp(argv[1], "save") == 0)
+    {
+        return cal_save();
+    }
+    else if (rt_strcmp(argv[1], "show") == 0)
+    {
+        joystick_cal_record_t def;
+
+        if (cal_flash->magic == JOYSTICK_CAL_MAGIC && cal_flash->checksum == cal_checksum(cal_flash))
+        {
+            rt_kprintf("stored calibration:\n");
+            cal_print(cal_flash);
+        }
+        else
+        {
+            rt_kprintf("no stored calibration, using defaults:\n");
+            cal_default(&def);
+            cal_print(&def);
+        }
+        return 0;
+    }
+    else if (rt_strcmp(argv[1], "reset") == 0)
+    {
+        joystick_cal_record_t def;
+
+        flash_store_erase(FLASH_STORE_CALIB_ADDR, FLASH_STORE_SECTOR_SIZE);
+        cal_default(&def);
+        cal_apply(&def);
+        memset(&cal_pending, 0, sizeof(cal_pending));
+        rt_kprintf("calibration reset to defaults\n");
+        return 0;
+    }
+
+    rt_kprintf("unknown option: %s\n", argv[1]);
+    return -1;
 }
+MSH_CMD_EXPORT(joy_cal, joystick calibration: joy_cal run [seconds] | save | show | reset);
@@ -14,6 +14,18 @@
 extern "C" {
 #endif
 
+/* ================ 配置参数 ================ */
+
+#define JOYSTICK_SAMPLE_RATE_HZ  2000   /* 硬件定时采样频率(Hz)，最高可达数kHz */
+#define JOYSTICK_WAKE_RATE_HZ    100    /* 空闲唤醒模式下的窗口比较采样频率(Hz) */
+#define JOYSTICK_WAKE_BAND       1500   /* 唤醒窗口: 偏离校准中心超过此值(原始值)即唤醒 */
+
+/**
+ * @brief 原始帧钩子: frames为count帧、每帧4个轴(LX LY RX RY)的原始ADC值
+ * @note 在DMA中断中调用，最后一帧为最新采样
+ */
+typedef void (*joystick_frame_hook_t)(const uint16_t *frames, uint32_t count);
+
 /* 摇杆数据结构 */
 typedef struct {
     int16_t x;      /* X轴: -32768 ~ 32767 */
@@ -21,6 +33,29 @@ typedef struct {
     bool btn;       /* 按键: true=按下 */
 } joystick_data_t;
 
+/**
+ * @brief 同时读取双摇杆数据
+ * @param left  左摇杆输出数据
+ * @param right 右摇杆输出数据
+ * @return RT_EOK成功
+ * @note 4个轴取自同一帧采样，不等待转换
+ */
+rt_err_t joystick_read(joystick_data_t *left, joystick_data_t *right);
+
+/**
+ * @brief 启动一次4通道转换
+ * @note 结果由DMA写入环形缓冲区，下次读取时即为最新数据；
+ *       硬件定时触发模式下采样由CTIMER驱动，此函数为空操作
+ */
+void joystick_sample_start(void);
+
+/**
+ * @brief 设置硬件定时采样频率
+ * @param rate_hz 每秒完整4轴采样次数
+ * @return RT_EOK成功，-RT_ENOSYS表示未使用硬件触发
+ */
+rt_err_t joystick_set_sample_rate(uint32_t rate_hz);
+
 /**
  * @brief 读取左摇杆数据
  * @param data 输出数据
@@ -45,6 +80,32 @@ rt_err_t joystick_right_read(joystick_data_t *data);
 void joystick_read_raw(uint32_t *left_x, uint32_t *left_y,
                        uint32_t *right_x, uint32_t *right_y);
 
+/**
+ * @brief 获取当前硬件定时采样频率
+ * @return 采样频率(Hz)，未使用硬件触发时返回0
+ */
+uint32_t joystick_get_sample_rate(void);
+
+/**
+ * @brief 设置原始帧钩子(调试采集用)，使能后每半个环形缓冲区调用一次
+ * @param hook 钩子函数，RT_NULL表示取消
+ * @return RT_EOK成功，-RT_ENOSYS表示未使用DMA采集
+ */
+rt_err_t joystick_set_frame_hook(joystick_frame_hook_t hook);
+
+/**
+ * @brief 进入空闲唤醒模式: 由LPADC窗口比较监视摇杆，摇杆按键挂接中断
+ * @param wake_sem 任一轴离开中心窗口或摇杆按键按下时释放的信号量
+ * @return RT_EOK成功，-RT_ENOSYS表示当前采集方式不支持(调用方应继续轮询)
+ * @note 期间停止DMA采集，joystick_read读到的是进入前的数据
+ */
+rt_err_t joystick_wake_arm(rt_sem_t wake_sem);
+
+/**
+ * @brief 退出空闲唤醒模式，恢复DMA连续采集
+ */
+void joystick_wake_disarm(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,4 +1,7 @@
 #include "key_app.h"
+#include <board.h>
+#include "fsl_ctimer.h"
+#include "timestamp.h"
 
 // C（column）：列  主动驱动低电平进行扫描
 // R（row）   ：行  默认高电平，按键按下时被拉低
@@ -11,6 +14,55 @@
 #define KEY_R3   ((3*32)+15)
 #define KEY_R4   ((3*32)+14)
 
+/* 端口寄存器直接访问: 列全部位于P2_3..P2_6，行全部位于P3_14..P3_17 */
+#define KEY_COL_PORT    GPIO2
+#define KEY_ROW_PORT    GPIO3
+#define KEY_COL_BIT(c)  (1u << (3 + (c)))       /* C1..C4 -> P2_3..P2_6 */
+#define KEY_ROW_SHIFT   14                      /* R4..R1 -> P3_14..P3_17 */
+#define KEY_SETTLE_US   5                       /* 列切换后的稳定时间 */
+
+/* 定时扫描引擎使用的CTIMER */
+#define KEY_SCAN_CTIMER         CTIMER0
+#define KEY_SCAN_CTIMER_DIV     kCLOCK_DivCTIMER0
+#define KEY_SCAN_CTIMER_CLK     kFRO_HF_to_CTIMER0
+#define KEY_SCAN_CTIMER_FREQ()  CLOCK_GetCTimerClkFreq(0U)
+
+/* 引脚数组 */
+static const rt_base_t col_pins[4] = {KEY_C1, KEY_C2, KEY_C3, KEY_C4};
+static const rt_base_t row_pins[4] = {KEY_R1, KEY_R2, KEY_R3, KEY_R4};
+
+/* 唤醒信号量，RT_NULL表示未处于唤醒等待模式 */
+static rt_sem_t key_wake_sem = RT_NULL;
+
+/* 消抖状态，定时扫描模式下在中断中更新 */
+static key_debounce_t key_db;
+
+/* 定时扫描引擎状态 */
+static volatile rt_bool_t scan_running = RT_FALSE;
+static volatile rt_uint16_t scan_raw = 0;   /* 最近一次完整扫描的原始位图 */
+static volatile rt_uint16_t scan_state = 0; /* 最近一次消抖后的位图 */
+static rt_uint8_t scan_col = 0;             /* 当前驱动的列 */
+static rt_uint16_t scan_acc = 0;            /* 本轮扫描累计的位图 */
+static rt_uint32_t scan_rate_hz = 0;
+
+/* 鬼键屏蔽状态 */
+static rt_uint16_t ghost_prev = 0;          /* 上一次屏蔽后的位图 */
+static rt_uint16_t ghost_amb_prev = 0;      /* 上一次被暂扣的歧义键 */
+static volatile rt_uint32_t ghost_count = 0; /* 被屏蔽的鬼键事件次数 */
+
+/* 原始扫描结果钩子 */
+static volatile key_raw_hook_t key_raw_hook = RT_NULL;
+
+/* 按键事件队列: 扫描端只写head，消费端只写tail */
+static key_event_t evt_buf[KEY_EVENT_QUEUE_SIZE];
+static volatile rt_uint32_t evt_head = 0;
+static volatile rt_uint32_t evt_tail = 0;
+static volatile rt_uint32_t evt_dropped = 0;
+
+static void key_row_irq(void *args);
+static void key_scan_tick(uint32_t flags);
+static ctimer_callback_t key_scan_cb[] = {key_scan_tick};
+
 /* 初始化函数 */
 static int key_init(void)
 {
@@ -32,20 +84,28 @@ static int key_init(void)
 	rt_pin_write(KEY_C3, PIN_HIGH);
 	rt_pin_write(KEY_C4, PIN_HIGH);
 
+	/* 行引脚挂接下降沿中断，默认关闭，仅在唤醒等待模式下使能 */
+	for (rt_uint8_t row = 0; row < 4; row++)
+	{
+		rt_pin_attach_irq(row_pins[row], PIN_IRQ_MODE_FALLING, key_row_irq, RT_NULL);
+	}
+
+	key_debounce_init(&key_db, KEY_DEBOUNCE_SAMPLES, KEY_DEBOUNCE_EAGER);
+
+#if KEY_SCAN_USE_TIMER
+	key_scan_start(KEY_SCAN_RATE_HZ);
+#endif
+
 	rt_kprintf("KEY OK\r\n");
 
 	return 0;
 }
 INIT_DEVICE_EXPORT(key_init);
 
-/* 引脚数组 */
-static const rt_base_t col_pins[4] = {KEY_C1, KEY_C2, KEY_C3, KEY_C4};
-static const rt_base_t row_pins[4] = {KEY_R1, KEY_R2, KEY_R3, KEY_R4};
-
-/* 读取按键状态 */
-rt_uint8_t key_read(void)
+/* PIN设备框架扫描: 每次扫描16次rt_pin_write + 16次rt_pin_read */
+static rt_uint16_t key_scan_pin(void)
 {
-	rt_uint8_t temp = 0xFF;  /* 0xFF表示无按键，0-15表示按键索引 */
+	rt_uint16_t bitmap = 0;
 
 	/* 逐列扫描 */
 	for (rt_uint8_t col = 0; col < 4; col++)
@@ -57,25 +117,536 @@ rt_uint8_t key_read(void)
 		}
 
 		/* 短暂延时，等待信号稳定 */
-		rt_hw_us_delay(5);
+		rt_hw_us_delay(KEY_SETTLE_US);
 
-		/* 检测所有行 */
+		/* 检测所有行，不提前退出，保证组合键都能被记录 */
 		for (rt_uint8_t row = 0; row < 4; row++)
 		{
 			if (rt_pin_read(row_pins[row]) == PIN_LOW)
 			{
-				temp = col * 4 + row;
-				goto scan_done;  /* 找到按键，立即退出扫描 */
+				bitmap |= (rt_uint16_t)(1u << (col * 4 + row));
 			}
 		}
 	}
 
-scan_done:
 	/* 恢复所有列为高电平 */
 	for (rt_uint8_t i = 0; i < 4; i++)
 	{
 		rt_pin_write(col_pins[i], PIN_HIGH);
 	}
 
-	return temp;
-}
\ No newline at end of file
+	return bitmap;
+}
+
+/*
+ * 列翻转表: 扫描开始时4列均为高电平，每一步只需一次PTOR写入
+ * 即可把上一列拉回高电平并把当前列拉低，最后一项恢复C4为高电平
+ */
+static const rt_uint32_t col_toggle[5] = {
+	KEY_COL_BIT(0),
+	KEY_COL_BIT(0) | KEY_COL_BIT(1),
+	KEY_COL_BIT(1) | KEY_COL_BIT(2),
+	KEY_COL_BIT(2) | KEY_COL_BIT(3),
+	KEY_COL_BIT(3),
+};
+
+/*
+ * 行电平 -> 按下位图: 输入bit0..3对应P3_14..P3_17(即R4..R1)，低电平有效，
+ * 输出bit0..3对应R1..R4
+ */
+static const rt_uint8_t row_decode[16] = {
+	0xF, 0x7, 0xB, 0x3, 0xD, 0x5, 0x9, 0x1,
+	0xE, 0x6, 0xA, 0x2, 0xC, 0x4, 0x8, 0x0,
+};
+
+/* 端口寄存器扫描: 每列一次PTOR写入 + 一次PDIR读取 */
+static rt_uint16_t key_scan_port(void)
+{
+	rt_uint16_t bitmap = 0;
+
+	for (rt_uint8_t col = 0; col < 4; col++)
+	{
+		KEY_COL_PORT->PTOR = col_toggle[col];
+
+		rt_hw_us_delay(KEY_SETTLE_US);
+
+		bitmap |= (rt_uint16_t)row_decode[(KEY_ROW_PORT->PDIR >> KEY_ROW_SHIFT) & 0xF] << (col * 4);
+	}
+
+	KEY_COL_PORT->PTOR = col_toggle[4];
+
+	return bitmap;
+}
+
+/* 全矩阵扫描，每次都扫完4列，返回所有按下按键的位图 */
+rt_uint16_t key_scan(void)
+{
+	/* 定时扫描引擎运行时直接返回最近一次完整扫描结果 */
+	if (scan_running)
+		return scan_raw;
+
+#if KEY_SCAN_USE_PORT_IO
+	return key_scan_port();
+#else
+	return key_scan_pin();
+#endif
+}
+
+/* ================ 鬼键屏蔽 ================ */
+
+/*
+ * 无二极管矩阵中，任意两列的行位图有2个及以上公共位时，
+ * 这些交点构成矩形，其中任意一个都可能是鬼键。
+ * 查表返回列交集中有歧义的行，交集少于2位时为0
+ */
+static const rt_uint8_t ghost_rows[16] = {
+	0x0, 0x0, 0x0, 0x3, 0x0, 0x5, 0x6, 0x7,
+	0x0, 0x9, 0xA, 0xB, 0xC, 0xD, 0xE, 0xF,
+};
+
+/* 列组合: 4列两两组合共6对 */
+static const rt_uint8_t ghost_pairs[6][2] = {
+	{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3},
+};
+
+/*
+ * 检测矩形按键图案，有歧义的键保持上一次的状态:
+ * 已按下的键继续保持，新出现的歧义键暂不上报
+ */
+static rt_uint16_t key_ghost_filter(rt_uint16_t raw)
+{
+	rt_uint16_t amb = 0;
+	rt_uint16_t held;
+	rt_uint16_t out;
+
+	for (rt_uint8_t i = 0; i < 6; i++)
+	{
+		rt_uint8_t a = ghost_pairs[i][0];
+		rt_uint8_t b = ghost_pairs[i][1];
+		rt_uint16_t rows = ghost_rows[(raw >> (a * 4)) & (raw >> (b * 4)) & 0xF];
+
+		amb |= (rows << (a * 4)) | (rows << (b * 4));
+	}
+
+	/* 只统计新被暂扣的键，歧义键持续按住时不重复计数 */
+	held = raw & amb & ~ghost_prev;
+	if (held & ~ghost_amb_prev)
+		ghost_count++;
+	ghost_amb_prev = held;
+
+	out = (raw & ~amb) | (ghost_prev & amb);
+	ghost_prev = out;
+
+	return out;
+}
+
+/* ================ 按键事件队列 ================ */
+
+/* 写入一个事件，仅由扫描端调用 */
+static void key_event_push(rt_uint32_t time_us, rt_uint8_t key, rt_uint8_t pressed)
+{
+	rt_uint32_t head = evt_head;
+
+	if (head - evt_tail >= KEY_EVENT_QUEUE_SIZE)
+	{
+		evt_dropped++;
+		return;
+	}
+
+	evt_buf[head & (KEY_EVENT_QUEUE_SIZE - 1)].time_us = time_us;
+	evt_buf[head & (KEY_EVENT_QUEUE_SIZE - 1)].key = key;
+	evt_buf[head & (KEY_EVENT_QUEUE_SIZE - 1)].pressed = pressed;
+
+	/* 保证事件内容先于head对消费端可见 */
+	__DMB();
+	evt_head = head + 1;
+}
+
+/* 查看最早的未处理按键事件 */
+rt_bool_t key_event_peek(key_event_t *evt)
+{
+	rt_uint32_t tail = evt_tail;
+
+	if (tail == evt_head)
+		return RT_FALSE;
+
+	__DMB();
+	*evt = evt_buf[tail & (KEY_EVENT_QUEUE_SIZE - 1)];
+
+	return RT_TRUE;
+}
+
+/* 移除最早的按键事件 */
+void key_event_pop(void)
+{
+	__DMB();
+	evt_tail = evt_tail + 1;
+}
+
+/* 获取因队列满而丢弃的事件数 */
+rt_uint32_t key_event_dropped(void)
+{
+	return evt_dropped;
+}
+
+/* 扫描结果处理: 鬼键屏蔽 -> 消抖 -> 边沿写入事件队列 */
+static rt_uint16_t key_process(rt_uint16_t raw)
+{
+	rt_uint16_t old = key_db.state;
+	rt_uint16_t state, changed;
+	rt_uint32_t now;
+	key_raw_hook_t hook = key_raw_hook;
+
+	if (hook != RT_NULL)
+	{
+		hook(raw);
+	}
+
+#if KEY_GHOST_FILTER
+	raw = key_ghost_filter(raw);
+#endif
+	state = key_debounce_update(&key_db, raw);
+
+	changed = state ^ old;
+	if (changed)
+	{
+		now = ts_us();
+		for (rt_uint8_t i = 0; changed; i++, changed >>= 1)
+		{
+			if (changed & 1)
+				key_event_push(now, i, (state >> i) & 1);
+		}
+	}
+
+	return state;
+}
+
+/* 获取消抖后的按键状态 */
+rt_uint16_t key_get_state(void)
+{
+	if (scan_running)
+		return scan_state;
+
+	return key_process(key_scan());
+}
+
+/* 获取被屏蔽的鬼键事件次数 */
+rt_uint32_t key_ghost_count(void)
+{
+	return ghost_count;
+}
+
+/* 设置原始扫描结果钩子 */
+void key_set_raw_hook(key_raw_hook_t hook)
+{
+	key_raw_hook = hook;
+}
+
+/* ================ 定时扫描引擎 ================ */
+
+/*
+ * 循环列翻转表: 第n项把第n列拉回高电平并把下一列拉低，
+ * 最后一项从C4回到C1，扫描可以无限循环
+ */
+static const rt_uint32_t col_next_toggle[4] = {
+	KEY_COL_BIT(0) | KEY_COL_BIT(1),
+	KEY_COL_BIT(1) | KEY_COL_BIT(2),
+	KEY_COL_BIT(2) | KEY_COL_BIT(3),
+	KEY_COL_BIT(3) | KEY_COL_BIT(0),
+};
+
+/*
+ * 定时器中断: 采样上一拍驱动的列(已稳定一个完整节拍)，然后驱动下一列后立即返回。
+ * 每4拍完成一次完整扫描并更新消抖状态
+ */
+static void key_scan_tick(uint32_t flags)
+{
+	rt_uint8_t col = scan_col;
+
+	(void)flags;
+
+	rt_interrupt_enter();
+
+	scan_acc |= (rt_uint16_t)row_decode[(KEY_ROW_PORT->PDIR >> KEY_ROW_SHIFT) & 0xF] << (col * 4);
+	KEY_COL_PORT->PTOR = col_next_toggle[col];
+
+	if (col == 3)
+	{
+		scan_raw = scan_acc;
+		scan_state = key_process(scan_acc);
+		scan_acc = 0;
+		scan_col = 0;
+	}
+	else
+	{
+		scan_col = col + 1;
+	}
+
+	rt_interrupt_leave();
+}
+
+/* 从C1开始重新运行扫描状态机，调用前4列须均为高电平 */
+static void key_scan_resume(void)
+{
+	scan_col = 0;
+	scan_acc = 0;
+	KEY_COL_PORT->PTOR = KEY_COL_BIT(0);
+
+	CTIMER_Reset(KEY_SCAN_CTIMER);
+	CTIMER_StartTimer(KEY_SCAN_CTIMER);
+}
+
+/* 启动定时扫描引擎 */
+rt_err_t key_scan_start(rt_uint32_t rate_hz)
+{
+	ctimer_config_t config;
+	ctimer_match_config_t match;
+	rt_uint32_t tick_hz = rate_hz * 4;  /* 每列一拍 */
+
+	if (rate_hz == 0 || tick_hz > KEY_SCAN_CTIMER_FREQ() / 2)
+		return -RT_EINVAL;
+
+	if (scan_running)
+		key_scan_stop();
+
+	CLOCK_SetClockDiv(KEY_SCAN_CTIMER_DIV, 1u);
+	CLOCK_AttachClk(KEY_SCAN_CTIMER_CLK);
+
+	CTIMER_GetDefaultConfig(&config);
+	CTIMER_Init(KEY_SCAN_CTIMER, &config);
+
+	match.enableCounterReset = true;
+	match.enableCounterStop = false;
+	match.matchValue = KEY_SCAN_CTIMER_FREQ() / tick_hz - 1;
+	match.outControl = kCTIMER_Output_NoAction;
+	match.outPinInitState = false;
+	match.enableInterrupt = true;
+
+	CTIMER_RegisterCallBack(KEY_SCAN_CTIMER, key_scan_cb, kCTIMER_SingleCallback);
+	CTIMER_SetupMatch(KEY_SCAN_CTIMER, kCTIMER_Match_0, &match);
+
+	scan_rate_hz = rate_hz;
+	scan_running = RT_TRUE;
+	key_scan_resume();
+
+	return RT_EOK;
+}
+
+/* 停止定时扫描引擎，列恢复高电平 */
+void key_scan_stop(void)
+{
+	if (!scan_running)
+		return;
+
+	CTIMER_StopTimer(KEY_SCAN_CTIMER);
+	scan_running = RT_FALSE;
+	KEY_COL_PORT->PSOR = KEY_COL_BIT(0) | KEY_COL_BIT(1) | KEY_COL_BIT(2) | KEY_COL_BIT(3);
+}
+
+/* ================ 按键唤醒 ================ */
+
+/* 行引脚下降沿中断: 关闭全部行中断并唤醒扫描线程 */
+static void key_row_irq(void *args)
+{
+	(void)args;
+
+	for (rt_uint8_t row = 0; row < 4; row++)
+	{
+		rt_pin_irq_enable(row_pins[row], PIN_IRQ_DISABLE);
+	}
+
+	if (key_wake_sem != RT_NULL)
+	{
+		rt_sem_release(key_wake_sem);
+	}
+}
+
+/* 进入唤醒等待模式: 所有列拉低，任意键按下都会拉低对应行 */
+rt_err_t key_wake_arm(rt_sem_t wake_sem)
+{
+	if (wake_sem == RT_NULL)
+		return -RT_EINVAL;
+
+	key_wake_sem = wake_sem;
+
+	/* 暂停定时扫描，列由唤醒逻辑接管 */
+	if (scan_running)
+		CTIMER_StopTimer(KEY_SCAN_CTIMER);
+
+#if KEY_SCAN_USE_PORT_IO
+	KEY_COL_PORT->PCOR = KEY_COL_BIT(0) | KEY_COL_BIT(1) | KEY_COL_BIT(2) | KEY_COL_BIT(3);
+#else
+	for (rt_uint8_t i = 0; i < 4; i++)
+	{
+		rt_pin_write(col_pins[i], PIN_LOW);
+	}
+#endif
+
+	rt_hw_us_delay(KEY_SETTLE_US);
+
+	for (rt_uint8_t row = 0; row < 4; row++)
+	{
+		rt_pin_irq_enable(row_pins[row], PIN_IRQ_ENABLE);
+	}
+
+	/* 使能中断前已按下的键不会再产生下降沿，这里补一次检查 */
+	for (rt_uint8_t row = 0; row < 4; row++)
+	{
+		if (rt_pin_read(row_pins[row]) == PIN_LOW)
+		{
+			key_row_irq(RT_NULL);
+			break;
+		}
+	}
+
+	return RT_EOK;
+}
+
+/* 退出唤醒等待模式: 关闭行中断，列恢复高电平以便正常扫描 */
+void key_wake_disarm(void)
+{
+	for (rt_uint8_t row = 0; row < 4; row++)
+	{
+		rt_pin_irq_enable(row_pins[row], PIN_IRQ_DISABLE);
+	}
+
+	key_wake_sem = RT_NULL;
+
+#if KEY_SCAN_USE_PORT_IO
+	KEY_COL_PORT->PSOR = KEY_COL_BIT(0) | KEY_COL_BIT(1) | KEY_COL_BIT(2) | KEY_COL_BIT(3);
+#else
+	for (rt_uint8_t i = 0; i < 4; i++)
+	{
+		rt_pin_write(col_pins[i], PIN_HIGH);
+	}
+#endif
+
+	if (scan_running)
+		key_scan_resume();
+}
+
+/* ================ 按键消抖 ================ */
+
+/* 初始化消抖状态 */
+void key_debounce_init(key_debounce_t *db, rt_uint8_t window, rt_bool_t eager)
+{
+	if (window < 1) window = 1;
+	if (window > 7) window = 7;
+
+	db->state = 0;
+	for (rt_uint8_t n = 0; n < 3; n++)
+	{
+		db->cnt[n] = 0;
+		db->win[n] = (window & (1u << n)) ? 0xFFFF : 0x0000;
+	}
+	db->eager = eager ? 0xFFFF : 0x0000;
+}
+
+/*
+ * 垂直计数器消抖: 与稳定状态不同的键计数加1，相同的键计数清零，
+ * 计数达到窗口值的键翻转稳定状态。16个键同时处理，与按键数量无关
+ */
+rt_uint16_t key_debounce_update(key_debounce_t *db, rt_uint16_t raw)
+{
+	rt_uint16_t delta = raw ^ db->state;
+	rt_uint16_t c0 = db->cnt[0], c1 = db->cnt[1], c2 = db->cnt[2];
+	rt_uint16_t carry, hit, toggle;
+
+	/* 3位计数器并行加1 */
+	carry = c0;
+	c0 = ~c0;
+	c2 ^= c1 & carry;
+	c1 ^= carry;
+
+	/* 未变化的键计数清零 */
+	c0 &= delta;
+	c1 &= delta;
+	c2 &= delta;
+
+	/* 计数值等于窗口值的键确认翻转 */
+	hit = delta & ~((c0 ^ db->win[0]) | (c1 ^ db->win[1]) | (c2 ^ db->win[2]));
+
+	/* eager模式下新按下的键不等待窗口 */
+	toggle = hit | (delta & raw & db->eager);
+
+	db->state ^= toggle;
+	db->cnt[0] = c0 & ~toggle;
+	db->cnt[1] = c1 & ~toggle;
+	db->cnt[2] = c2 & ~toggle;
+
+	return db->state;
+}
+
+/* 读取按键状态 */
+rt_uint8_t key_read(void)
+{
+	rt_uint16_t bitmap = key_scan();
+
+	/* 返回索引最小的按键，与旧接口行为一致 */
+	for (rt_uint8_t i = 0; i < 16; i++)
+	{
+		if (bitmap & (1u << i))
+			return i;
+	}
+
+	return KEY_NONE;
+}
+
+/* ================ 调试命令 ================ */
+
+/* 对比两种扫描后端的CPU周期数(包含列稳定延时) */
+static int key_bench(int argc, char **argv)
+{
+	rt_uint32_t rounds = 100;
+	rt_uint32_t start, cycles;
+	rt_uint32_t pin_min = 0xFFFFFFFF, pin_sum = 0;
+	rt_uint32_t port_min = 0xFFFFFFFF, port_sum = 0;
+	rt_base_t level;
+	rt_bool_t was_running = scan_running;
+
+	/* 测量期间暂停定时扫描，避免与中断争用列引脚 */
+	key_scan_stop();
+
+	for (rt_uint32_t i = 0; i < rounds; i++)
+	{
+		level = rt_hw_interrupt_disable();
+		start = ts_cycles();
+		key_scan_pin();
+		cycles = ts_cycles() - start;
+		rt_hw_interrupt_enable(level);
+		pin_sum += cycles;
+		if (cycles < pin_min) pin_min = cycles;
+
+		level = rt_hw_interrupt_disable();
+		start = ts_cycles();
+		key_scan_port();
+		cycles = ts_cycles() - start;
+		rt_hw_interrupt_enable(level);
+		port_sum += cycles;
+		if (cycles < port_min) port_min = cycles;
+	}
+
+	rt_kprintf("key scan cycles (%d rounds, settle %dus x4 included)\n", rounds, KEY_SETTLE_US);
+	rt_kprintf("  rt_pin : min %d avg %d\n", pin_min, pin_sum / rounds);
+	rt_kprintf("  port io: min %d avg %d\n", port_min, port_sum / rounds);
+
+	if (was_running)
+		key_scan_start(scan_rate_hz);
+
+	return 0;
+}
+MSH_CMD_EXPORT(key_bench, compare key matrix scan backends);
+
+/* 查看鬼键屏蔽次数 */
+static int key_ghost(int argc, char **argv)
+{
+	if (argc > 1 && rt_strcmp(argv[1], "reset") == 0)
+	{
+		ghost_count = 0;
+	}
+
+	rt_kprintf("ghost masked: %d\n", ghost_count);
+
+	return 0;
+}
+MSH_CMD_EXPORT(key_ghost, show key matrix ghost mask count: key_ghost [reset]);
@@ -4,12 +4,156 @@
 #include <rtthread.h>
 #include <rtdevice.h>
 
+/* ================ 配置参数 ================ */
+
+/* 扫描后端: 1=直接操作端口寄存器(快速), 0=通过RT-Thread PIN设备框架 */
+#ifndef KEY_SCAN_USE_PORT_IO
+#define KEY_SCAN_USE_PORT_IO    1
+#endif
+
+/* 定时扫描: 1=由CTIMER中断驱动扫描状态机(需要端口寄存器后端), 0=调用时同步扫描 */
+#ifndef KEY_SCAN_USE_TIMER
+#define KEY_SCAN_USE_TIMER      1
+#endif
+#define KEY_SCAN_RATE_HZ        1000    /* 完整矩阵扫描频率(Hz)，每列占1/4周期 */
+
+#if KEY_SCAN_USE_TIMER && !KEY_SCAN_USE_PORT_IO
+#error "KEY_SCAN_USE_TIMER requires KEY_SCAN_USE_PORT_IO"
+#endif
+
+/* 鬼键屏蔽: 1=检测矩形按键图案并暂缓上报有歧义的键 */
+#define KEY_GHOST_FILTER        1
+
+/* 消抖窗口: 连续N次扫描与稳定状态不同才确认变化 (1-7)，1kHz扫描时即N毫秒 */
+#define KEY_DEBOUNCE_SAMPLES    5
+
+/* 消抖模式: 1=按下在首个边沿立即上报、只对释放消抖; 0=按下和释放都消抖 */
+#define KEY_DEBOUNCE_EAGER      1
+
+/* 按键事件队列长度(必须为2的幂) */
+#define KEY_EVENT_QUEUE_SIZE    32
+
+#define KEY_NONE        0xFF    /* key_read() 无按键时的返回值 */
+
+/* ================ 数据结构 ================ */
+
+/**
+ * @brief 按键消抖状态
+ * @note 16个按键的计数器按位平面存放(垂直计数器)，每次更新对全部按键并行处理
+ */
+typedef struct {
+    rt_uint16_t state;      /* 消抖后的按键位图 */
+    rt_uint16_t cnt[3];     /* 3位垂直计数器: cnt[n]为所有按键计数值的第n位 */
+    rt_uint16_t win[3];     /* 窗口值的位平面掩码 (0x0000或0xFFFF) */
+    rt_uint16_t eager;      /* 立即上报按下的掩码 (0x0000或0xFFFF) */
+} key_debounce_t;
+
+/**
+ * @brief 按键事件(消抖后的边沿)
+ */
+typedef struct {
+    rt_uint32_t time_us;    /* 事件时间戳(us)，见ts_us() */
+    rt_uint8_t key;         /* 按键索引 0-15 */
+    rt_uint8_t pressed;     /* 1=按下, 0=释放 */
+} key_event_t;
+
+/**
+ * @brief 原始扫描结果钩子，每次完整扫描后(鬼键屏蔽和消抖之前)调用
+ * @note 定时扫描模式下在中断中调用
+ */
+typedef void (*key_raw_hook_t)(rt_uint16_t raw);
+
 /**
  * @brief 读取按键状态
  * @return 按键状态
+ * @note 多键同时按下时只返回索引最小的按键，需要组合键请使用 key_scan()
  */
 rt_uint8_t key_read(void);
 
+/**
+ * @brief 全矩阵扫描(N键无冲)
+ * @return 16位按键位图，bit(col*4+row)=1表示该键按下
+ */
+rt_uint16_t key_scan(void);
 
-#endif
+/**
+ * @brief 获取消抖后的按键状态
+ * @return 16位按键位图
+ * @note 定时扫描模式下直接返回中断中维护的状态，否则同步扫描一次并消抖
+ */
+rt_uint16_t key_get_state(void);
 
+/**
+ * @brief 查看最早的未处理按键事件(不移出队列)
+ * @param evt 输出事件
+ * @return RT_TRUE表示有事件
+ * @note 单生产者(扫描)单消费者(报告构建)无锁队列，只能在一个线程中消费
+ */
+rt_bool_t key_event_peek(key_event_t *evt);
+
+/**
+ * @brief 移除最早的按键事件，须在key_event_peek()成功后调用
+ */
+void key_event_pop(void);
+
+/**
+ * @brief 获取因队列满而丢弃的事件数
+ * @return 丢弃的事件数
+ */
+rt_uint32_t key_event_dropped(void);
+
+/**
+ * @brief 获取被屏蔽的鬼键事件次数
+ * @return 自启动以来出现新歧义键而被暂缓上报的次数
+ */
+rt_uint32_t key_ghost_count(void);
+
+/**
+ * @brief 设置原始扫描结果钩子(调试采集用)
+ * @param hook 钩子函数，RT_NULL表示取消
+ */
+void key_set_raw_hook(key_raw_hook_t hook);
+
+/**
+ * @brief 启动定时扫描引擎
+ * @param rate_hz 完整矩阵扫描频率(Hz)
+ * @return RT_EOK成功
+ * @note 每个定时器节拍采样上一列并驱动下一列，列稳定期间不占用CPU
+ */
+rt_err_t key_scan_start(rt_uint32_t rate_hz);
+
+/**
+ * @brief 停止定时扫描引擎，之后key_scan()恢复同步扫描
+ */
+void key_scan_stop(void);
+
+/**
+ * @brief 进入按键唤醒等待模式
+ * @param wake_sem 任意键按下时释放的信号量
+ * @return RT_EOK成功
+ * @note 所有列保持低电平，四个行引脚以下降沿中断唤醒；期间不能调用key_scan()
+ */
+rt_err_t key_wake_arm(rt_sem_t wake_sem);
+
+/**
+ * @brief 退出按键唤醒等待模式，恢复正常扫描
+ */
+void key_wake_disarm(void);
+
+/**
+ * @brief 初始化消抖状态
+ * @param db 消抖状态
+ * @param window 消抖窗口(扫描次数, 1-7)
+ * @param eager RT_TRUE表示按下立即上报，只对释放消抖
+ */
+void key_debounce_init(key_debounce_t *db, rt_uint8_t window, rt_bool_t eager);
+
+/**
+ * @brief 输入一次原始扫描结果，返回消抖后的位图
+ * @param db 消抖状态
+ * @param raw key_scan()返回的原始位图
+ * @return 消抖后的按键位图
+ */
+rt_uint16_t key_debounce_update(key_debounce_t *db, rt_uint16_t raw);
+
+#endif
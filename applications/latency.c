@@ -0,0 +1,169 @@
+/**
+ * @file latency.c
+ * @brief 输入到USB传输完成的分段延迟统计实现
+ * @details 直方图按周期数的对数分桶: 小于16个周期逐个计数，
+ *          之后每个2的幂区间分8个桶，相对误差不超过12.5%
+ */
+
+#include "latency.h"
+
+#if LATENCY_ENABLE
+
+#include <board.h>
+#include <rthw.h>
+#include <string.h>
+
+/* ================ 内部定义 ================ */
+
+#define LAT_LINEAR          16      /* 线性区桶数 */
+#define LAT_SUB_BITS        3       /* 每个2的幂区间的子桶位数 */
+#define LAT_MAX_EXP         27      /* 覆盖到2^28周期 (96MHz下约2.8s) */
+#define LAT_BUCKETS         (LAT_LINEAR + (LAT_MAX_EXP - 3) * (1 << LAT_SUB_BITS))
+
+/* 统计的阶段 */
+enum {
+    STAGE_SCAN_ADC = 0,     /* 扫描 + 摇杆读取 */
+    STAGE_ADC_BUILT,        /* 滤波、整形、映射、生成报告 */
+    STAGE_BUILT_ARMED,      /* 等待端点空闲 */
+    STAGE_ARMED_DONE,       /* 等待主机轮询并完成传输 */
+    STAGE_TOTAL,            /* 扫描开始到传输完成 */
+    STAGE_NUM
+};
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t bucket[LAT_BUCKETS];
+} lat_hist_t;
+
+/* ================ 内部变量 ================ */
+
+latency_rec_t latency_build;
+latency_rec_t latency_slot[LATENCY_SLOTS];
+
+static lat_hist_t lat_hist[STAGE_NUM];
+
+/* ================ 内部函数 ================ */
+
+/* 周期数所在的桶 */
+static uint32_t lat_bucket(uint32_t v)
+{
+    uint32_t e;
+
+    if (v < LAT_LINEAR)
+        return v;
+
+    e = 31 - __CLZ(v);                  /* v >= 16 时 e >= 4 */
+    if (e > LAT_MAX_EXP)
+        return LAT_BUCKETS - 1;
+
+    return LAT_LINEAR + (e - 4) * (1 << LAT_SUB_BITS) + ((v >> (e - LAT_SUB_BITS)) & ((1 << LAT_SUB_BITS) - 1));
+}
+
+/* 桶的下界 */
+static uint32_t lat_bucket_floor(uint32_t b)
+{
+    uint32_t e, sub;
+
+    if (b < LAT_LINEAR)
+        return b;
+
+    e = (b - LAT_LINEAR) / (1 << LAT_SUB_BITS) + 4;
+    sub = (b - LAT_LINEAR) % (1 << LAT_SUB_BITS);
+
+    return (1u << e) | (sub << (e - LAT_SUB_BITS));
+}
+
+static void lat_add(lat_hist_t *h, uint32_t v)
+{
+    if (h->count == 0 || v < h->min)
+        h->min = v;
+    if (v > h->max)
+        h->max = v;
+    h->count++;
+    h->bucket[lat_bucket(v)]++;
+}
+
+/* ================ 公共API ================ */
+
+/* 记录传输完成并更新直方图 */
+void latency_commit(uint8_t slot)
+{
+    latency_rec_t *r = &latency_slot[slot];
+
+    r->t[LATENCY_DONE] = ts_cycles();
+
+    lat_add(&lat_hist[STAGE_SCAN_ADC], r->t[LATENCY_ADC] - r->t[LATENCY_SCAN]);
+    lat_add(&lat_hist[STAGE_ADC_BUILT], r->t[LATENCY_BUILT] - r->t[LATENCY_ADC]);
+    lat_add(&lat_hist[STAGE_BUILT_ARMED], r->t[LATENCY_ARMED] - r->t[LATENCY_BUILT]);
+    lat_add(&lat_hist[STAGE_ARMED_DONE], r->t[LATENCY_DONE] - r->t[LATENCY_ARMED]);
+    lat_add(&lat_hist[STAGE_TOTAL], r->t[LATENCY_DONE] - r->t[LATENCY_SCAN]);
+}
+
+/* ================ 调试命令 ================ */
+
+/* 以0.1us为单位打印周期数 */
+static void lat_print_cycles(uint32_t cycles)
+{
+    uint32_t mhz = SystemCoreClock / 1000000;
+    uint32_t tenth = (uint32_t)((uint64_t)cycles * 10 / (mhz ? mhz : 1));
+
+    rt_kprintf(" %6d.%d", tenth / 10, tenth % 10);
+}
+
+/* 分位数所在桶的下界 */
+static uint32_t lat_percentile(const lat_hist_t *h, uint32_t permille)
+{
+    uint32_t target = (uint32_t)(((uint64_t)h->count * permille + 999) / 1000);
+    uint32_t acc = 0;
+
+    for (uint32_t b = 0; b < LAT_BUCKETS; b++)
+    {
+        acc += h->bucket[b];
+        if (acc >= target)
+            return lat_bucket_floor(b);
+    }
+
+    return h->max;
+}
+
+static int latency(int argc, char **argv)
+{
+    static const char *const stage_names[STAGE_NUM] = {
+        "scan->adc", "adc->built", "built->armed", "armed->done", "total"
+    };
+    static lat_hist_t snap;
+    rt_base_t level;
+
+    rt_kprintf("stage(us)        count      min      p50      p99      max\n");
+    for (uint32_t s = 0; s < STAGE_NUM; s++)
+    {
+        /* 关中断取快照，打印期间发送完成中断可继续更新统计 */
+        level = rt_hw_interrupt_disable();
+        memcpy(&snap, &lat_hist[s], sizeof(snap));
+        rt_hw_interrupt_enable(level);
+
+        rt_kprintf("%-12s %9d", stage_names[s], snap.count);
+        if (snap.count)
+        {
+            lat_print_cycles(snap.min);
+            lat_print_cycles(lat_percentile(&snap, 500));
+            lat_print_cycles(lat_percentile(&snap, 990));
+            lat_print_cycles(snap.max);
+        }
+        rt_kprintf("\n");
+    }
+
+    if (argc > 1 && rt_strcmp(argv[1], "reset") == 0)
+    {
+        level = rt_hw_interrupt_disable();
+        memset(lat_hist, 0, sizeof(lat_hist));
+        rt_hw_interrupt_enable(level);
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(latency, show per-stage input to USB latency: latency [reset]);
+
+#endif /* LATENCY_ENABLE */
@@ -0,0 +1,73 @@
+/**
+ * @file latency.h
+ * @brief 输入到USB传输完成的分段延迟统计
+ * @details 用DWT周期计数器给每份报告的各阶段打时间戳:
+ *          扫描开始 -> 摇杆数据就绪 -> 报告生成 -> 启动IN传输 -> 传输完成，
+ *          传输完成时把各段耗时计入直方图。LATENCY_ENABLE为0时所有宏为空，不产生任何代码
+ */
+
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+#include "timestamp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ================ 配置参数 ================ */
+
+#define LATENCY_ENABLE      1       /* 0: 关闭统计，打点宏全部编译为空 */
+#define LATENCY_SLOTS       3       /* 报告缓冲区数，须与usb_app的槽位数一致 */
+
+/* 时间戳位置 */
+enum {
+    LATENCY_SCAN = 0,       /* 输入循环开始扫描 */
+    LATENCY_ADC,            /* 摇杆数据读取完成 */
+    LATENCY_BUILT,          /* 报告生成完成 */
+    LATENCY_ARMED,          /* usbd_ep_start_write 已调用 */
+    LATENCY_DONE,           /* 发送完成回调 */
+    LATENCY_POINTS
+};
+
+/* 一份报告的时间戳 */
+typedef struct {
+    uint32_t t[LATENCY_POINTS];
+} latency_rec_t;
+
+#if LATENCY_ENABLE
+
+extern latency_rec_t latency_build;
+extern latency_rec_t latency_slot[LATENCY_SLOTS];
+
+/* 正在生成的报告打点 (输入线程) */
+#define LATENCY_MARK(point)             (latency_build.t[point] = ts_cycles())
+/* 报告发布到某个缓冲区 */
+#define LATENCY_PUBLISH(slot)           (latency_slot[slot] = latency_build)
+/* 已发布报告打点 */
+#define LATENCY_SLOT_MARK(slot, point)  (latency_slot[slot].t[point] = ts_cycles())
+/* 传输完成，计入统计 (中断上下文) */
+#define LATENCY_DONE_SLOT(slot)         latency_commit(slot)
+
+/**
+ * @brief 记录传输完成并更新直方图
+ * @param slot 报告缓冲区号
+ */
+void latency_commit(uint8_t slot);
+
+#else
+
+#define LATENCY_MARK(point)             ((void)0)
+#define LATENCY_PUBLISH(slot)           ((void)0)
+#define LATENCY_SLOT_MARK(slot, point)  ((void)0)
+#define LATENCY_DONE_SLOT(slot)         ((void)0)
+
+#endif /* LATENCY_ENABLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LATENCY_H__ */
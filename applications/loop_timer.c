@@ -0,0 +1,257 @@
+/**
+ * @file loop_timer.c
+ * @brief 输入循环硬件节拍实现
+ * @details MAT0产生节拍并复位计数器，MAT1为可选的探测点。
+ *          节拍周期只由定时器决定，线程执行时间不会累积到周期里
+ */
+
+#include "loop_timer.h"
+#include "timestamp.h"
+#include <board.h>
+#include <rthw.h>
+#include "fsl_ctimer.h"
+
+/* ================ 硬件配置 ================ */
+
+#define LOOP_CTIMER             CTIMER2
+#define LOOP_CTIMER_DIV         kCLOCK_DivCTIMER2
+#define LOOP_CTIMER_CLK         kFRO_HF_to_CTIMER2
+#define LOOP_CTIMER_FREQ()      CLOCK_GetCTimerClkFreq(2U)
+
+/* ================ 内部变量 ================ */
+
+static void loop_tick_cb(uint32_t flags);
+static void loop_probe_cb(uint32_t flags);
+
+/* 多回调模式下驱动按中断源下标取回调: MAT0-3, CAP0-3 */
+static ctimer_callback_t loop_cb[8] = {loop_tick_cb, loop_probe_cb};
+
+static struct rt_semaphore tick_sem;
+static volatile bool loop_running = false;
+static uint32_t counts_per_us = 0;
+static uint32_t period_counts = 0;
+static uint32_t period_us = 0;
+
+static loop_timer_hook_t tick_hook = RT_NULL;
+static loop_timer_hook_t probe_hook = RT_NULL;
+
+static volatile uint32_t tick_count = 0;
+static volatile uint32_t tick_us = 0;       /* 最近一个节拍的时间 */
+static uint32_t seen_count = 0;             /* 线程已处理到的节拍 */
+static uint32_t run_tick_us = 0;            /* 当前循环所属节拍的时间 */
+static bool run_active = false;
+
+static uint32_t stat_runs = 0;
+static uint32_t stat_missed = 0;
+static uint32_t stat_work_max = 0;
+static uint32_t stat_wake_max = 0;
+
+/* ================ 中断回调 ================ */
+
+/* 节拍: 恢复标称周期并唤醒输入线程 */
+static void loop_tick_cb(uint32_t flags)
+{
+    (void)flags;
+
+    rt_interrupt_enter();
+
+    LOOP_CTIMER->MR[kCTIMER_Match_0] = period_counts - 1;
+    tick_count++;
+    tick_us = ts_us();
+
+    if (tick_hook != RT_NULL)
+        tick_hook();
+
+    rt_sem_release(&tick_sem);
+
+    rt_interrupt_leave();
+}
+
+/* 探测点 */
+static void loop_probe_cb(uint32_t flags)
+{
+    (void)flags;
+
+    rt_interrupt_enter();
+
+    if (probe_hook != RT_NULL)
+        probe_hook();
+
+    rt_interrupt_leave();
+}
+
+/* ================ 公共API ================ */
+
+/* 启动节拍 */
+rt_err_t loop_timer_start(uint32_t period)
+{
+    ctimer_config_t config;
+    ctimer_match_config_t match;
+
+    if (period < LOOP_TIMER_PERIOD_MIN_US || period > LOOP_TIMER_PERIOD_MAX_US)
+        return -RT_EINVAL;
+
+    if (loop_running)
+        loop_timer_stop();
+
+    CLOCK_SetClockDiv(LOOP_CTIMER_DIV, 1u);
+    CLOCK_AttachClk(LOOP_CTIMER_CLK);
+
+    counts_per_us = LOOP_CTIMER_FREQ() / 1000000;
+    if (counts_per_us == 0)
+        return -RT_ERROR;
+
+    period_us = period;
+    period_counts = counts_per_us * period;
+
+    CTIMER_GetDefaultConfig(&config);
+    CTIMER_Init(LOOP_CTIMER, &config);
+
+    /* MAT0: 节拍，复位计数器 */
+    match.enableCounterReset = true;
+    match.enableCounterStop = false;
+    match.matchValue = period_counts - 1;
+    match.outControl = kCTIMER_Output_NoAction;
+    match.outPinInitState = false;
+    match.enableInterrupt = true;
+    CTIMER_SetupMatch(LOOP_CTIMER, kCTIMER_Match_0, &match);
+
+    CTIMER_RegisterCallBack(LOOP_CTIMER, loop_cb, kCTIMER_MultipleCallback);
+
+    rt_sem_control(&tick_sem, RT_IPC_CMD_RESET, RT_NULL);
+    seen_count = tick_count;
+    run_active = false;
+    loop_running = true;
+    CTIMER_StartTimer(LOOP_CTIMER);
+
+    return RT_EOK;
+}
+
+/* 停止节拍 */
+void loop_timer_stop(void)
+{
+    if (!loop_running)
+        return;
+
+    CTIMER_StopTimer(LOOP_CTIMER);
+    loop_running = false;
+    run_active = false;
+    tick_hook = RT_NULL;
+    probe_hook = RT_NULL;
+}
+
+/* 节拍是否在运行 */
+bool loop_timer_running(void)
+{
+    return loop_running;
+}
+
+/* 设置相位控制回调 */
+rt_err_t loop_timer_set_hooks(loop_timer_hook_t tick, loop_timer_hook_t probe, uint32_t offset_us)
+{
+    ctimer_match_config_t match;
+
+    if (!loop_running)
+        return -RT_ERROR;
+    if (probe != RT_NULL && (offset_us == 0 || offset_us >= period_us))
+        return -RT_EINVAL;
+
+    match.enableCounterReset = false;
+    match.enableCounterStop = false;
+    match.matchValue = offset_us * counts_per_us;
+    match.outControl = kCTIMER_Output_NoAction;
+    match.outPinInitState = false;
+    match.enableInterrupt = (probe != RT_NULL);
+
+    tick_hook = tick;
+    probe_hook = probe;
+    CTIMER_SetupMatch(LOOP_CTIMER, kCTIMER_Match_1, &match);
+
+    return RT_EOK;
+}
+
+/* 调整当前周期长度 */
+void loop_timer_trim(int32_t delta_us)
+{
+    LOOP_CTIMER->MR[kCTIMER_Match_0] = (uint32_t)((int32_t)period_counts + delta_us * (int32_t)counts_per_us) - 1;
+}
+
+/* 等待下一个节拍 */
+rt_err_t loop_timer_wait(rt_int32_t timeout)
+{
+    rt_base_t level;
+    rt_err_t ret;
+    uint32_t now = ts_us();
+
+    if (run_active)
+    {
+        stat_runs++;
+        if (now - run_tick_us > stat_work_max)
+            stat_work_max = now - run_tick_us;
+    }
+
+    /* 工作期间已经到来的节拍属于错过的周期，丢弃后在下一个节拍边界恢复 */
+    level = rt_hw_interrupt_disable();
+    while (rt_sem_trytake(&tick_sem) == RT_EOK)
+        ;
+    stat_missed += tick_count - seen_count;
+    seen_count = tick_count;
+    rt_hw_interrupt_enable(level);
+
+    ret = rt_sem_take(&tick_sem, timeout);
+    if (ret != RT_EOK)
+    {
+        run_active = false;
+        return ret;
+    }
+
+    level = rt_hw_interrupt_disable();
+    seen_count = tick_count;
+    run_tick_us = tick_us;
+    rt_hw_interrupt_enable(level);
+
+    now = ts_us();
+    if (now - run_tick_us > stat_wake_max)
+        stat_wake_max = now - run_tick_us;
+    run_active = true;
+
+    return RT_EOK;
+}
+
+/* 当前循环所属的节拍序号 */
+uint32_t loop_timer_tick(void)
+{
+    return seen_count;
+}
+
+/* 当前节拍周期 */
+uint32_t loop_timer_period(void)
+{
+    return loop_running ? period_us : 0;
+}
+
+/* 获取运行统计 */
+void loop_timer_get_stats(loop_timer_stats_t *stats, bool reset)
+{
+    stats->period_us = loop_running ? period_us : 0;
+    stats->ticks = tick_count;
+    stats->runs = stat_runs;
+    stats->missed = stat_missed;
+    stats->work_max_us = stat_work_max;
+    stats->wake_max_us = stat_wake_max;
+
+    if (reset)
+    {
+        stat_runs = 0;
+        stat_missed = 0;
+        stat_work_max = 0;
+        stat_wake_max = 0;
+    }
+}
+
+static int loop_timer_init(void)
+{
+    rt_sem_init(&tick_sem, "loop", 0, RT_IPC_FLAG_FIFO);
+    return 0;
+}
+INIT_PREV_EXPORT(loop_timer_init);
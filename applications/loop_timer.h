@@ -0,0 +1,102 @@
+/**
+ * @file loop_timer.h
+ * @brief 输入循环硬件节拍
+ * @details CTIMER2以固定周期产生节拍，输入线程每拍运行一次到底(run-to-completion)；
+ *          节拍不受线程执行时间影响，相位固定，超时的周期计入错过次数
+ */
+
+#ifndef __LOOP_TIMER_H__
+#define __LOOP_TIMER_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ================ 配置参数 ================ */
+
+#define LOOP_TIMER_PERIOD_MIN_US    125     /* 允许的最短周期 */
+#define LOOP_TIMER_PERIOD_MAX_US    100000  /* 允许的最长周期 */
+
+/* 节拍/探测回调，在定时器中断中调用 */
+typedef void (*loop_timer_hook_t)(void);
+
+/* 运行统计 */
+typedef struct {
+    uint32_t period_us;     /* 当前周期 */
+    uint32_t ticks;         /* 节拍总数 */
+    uint32_t runs;          /* 完成的循环次数 */
+    uint32_t missed;        /* 因超时跳过的节拍数 */
+    uint32_t work_max_us;   /* 节拍到循环结束的最长时间 */
+    uint32_t wake_max_us;   /* 节拍到线程恢复运行的最长时间 */
+} loop_timer_stats_t;
+
+/**
+ * @brief 启动节拍，已在运行时按新周期重启
+ * @param period_us 节拍周期
+ * @return RT_EOK成功，-RT_EINVAL周期超出范围
+ */
+rt_err_t loop_timer_start(uint32_t period_us);
+
+/**
+ * @brief 停止节拍并清除回调
+ */
+void loop_timer_stop(void);
+
+/**
+ * @brief 节拍是否在运行
+ */
+bool loop_timer_running(void);
+
+/**
+ * @brief 设置相位控制回调，供外部时钟锁相使用
+ * @param tick 每个节拍调用，可为RT_NULL
+ * @param probe 节拍后offset_us处调用，可为RT_NULL
+ * @param offset_us 探测点相对节拍的时间，需小于周期
+ * @return RT_EOK成功
+ */
+rt_err_t loop_timer_set_hooks(loop_timer_hook_t tick, loop_timer_hook_t probe, uint32_t offset_us);
+
+/**
+ * @brief 仅调整当前这一个周期的长度，下个节拍自动恢复标称周期
+ * @param delta_us 调整量，正数延长，负数缩短
+ * @note 只能在探测回调中调用
+ */
+void loop_timer_trim(int32_t delta_us);
+
+/**
+ * @brief 等待下一个节拍
+ * @param timeout 最长等待时间(tick)
+ * @return RT_EOK收到节拍，-RT_ETIMEOUT超时
+ * @details 上一个节拍后的工作超出周期时，期间的节拍被丢弃并计入missed，
+ *          循环始终在节拍边界上恢复，保持相位
+ */
+rt_err_t loop_timer_wait(rt_int32_t timeout);
+
+/**
+ * @brief 当前循环所属的节拍序号
+ * @return 节拍计数，错过的节拍同样计入，可作为循环的时间基准
+ */
+uint32_t loop_timer_tick(void);
+
+/**
+ * @brief 当前节拍周期
+ * @return 周期(us)，未运行时返回0
+ */
+uint32_t loop_timer_period(void);
+
+/**
+ * @brief 获取运行统计
+ * @param stats 输出统计
+ * @param reset 读取后清零计数
+ */
+void loop_timer_get_stats(loop_timer_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LOOP_TIMER_H__ */
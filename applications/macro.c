@@ -0,0 +1,490 @@
+/**
+ * @file macro.c
+ * @brief 输入宏录制与回放实现
+ * @details 启停请求由命令线程提出，在输入线程的下一个节拍生效，
+ *          录制和回放的起点都落在节拍上，时间全部以节拍序号计算
+ */
+
+#include "macro.h"
+#include "loop_timer.h"
+#include "usb_app.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ================ 内部定义 ================ */
+
+#define MACRO_FIELDS        7       /* 按钮低/高字节、四轴、方向键 */
+#define MACRO_MASK_ALL      0x7F
+#define MACRO_EVENT_MAX     (5 + 1 + MACRO_FIELDS)  /* 单个事件最大字节数 */
+
+enum {
+    MACRO_IDLE = 0,
+    MACRO_RECORDING,
+    MACRO_PLAYING
+};
+
+enum {
+    MACRO_REQ_NONE = 0,
+    MACRO_REQ_RECORD,
+    MACRO_REQ_PLAY,
+    MACRO_REQ_STOP
+};
+
+/* 宏槽位在flash中的地址 */
+#define MACRO_SLOT_ADDR(slot)   (FLASH_STORE_MACRO_ADDR + (uint32_t)(slot) * MACRO_SLOT_SIZE)
+
+/* ================ 内部变量 ================ */
+
+static volatile uint8_t macro_state = MACRO_IDLE;
+static volatile uint8_t macro_req = MACRO_REQ_NONE;
+
+/* 录制缓冲区，头部在前，保存时整体写入flash */
+static union {
+    macro_header_t hdr;
+    uint8_t raw[MACRO_SLOT_SIZE];
+} rec_buf;
+static bool rec_valid = false;
+static bool rec_truncated = false;
+static uint32_t rec_pos = 0;
+static uint32_t rec_start_tick = 0;
+static uint32_t rec_last_tick = 0;
+static macro_frame_t rec_prev;
+
+/* 回放状态 */
+static const macro_header_t *play_hdr = RT_NULL;    /* 请求回放的宏 */
+static uint32_t play_loops_req = 0;
+static const uint8_t *play_ptr = RT_NULL;
+static const uint8_t *play_end = RT_NULL;
+static uint32_t play_loops = 0;
+static uint32_t play_start_tick = 0;
+static uint32_t play_due_us = 0;                     /* 下一事件相对起点的时间 */
+static macro_frame_t play_frame;
+
+/* ================ 编码 ================ */
+
+/* 把帧拆成字段 */
+static void frame_fields(const macro_frame_t *f, uint8_t out[MACRO_FIELDS])
+{
+    out[0] = (uint8_t)f->buttons;
+    out[1] = (uint8_t)(f->buttons >> 8);
+    out[2] = (uint8_t)f->axes[0];
+    out[3] = (uint8_t)f->axes[1];
+    out[4] = (uint8_t)f->axes[2];
+    out[5] = (uint8_t)f->axes[3];
+    out[6] = f->hat;
+}
+
+/* 把字段写回帧 */
+static void frame_set_field(macro_frame_t *f, uint8_t i, uint8_t v)
+{
+    if (i == 0)
+        f->buttons = (uint16_t)((f->buttons & 0xFF00) | v);
+    else if (i == 1)
+        f->buttons = (uint16_t)((f->buttons & 0x00FF) | ((uint16_t)v << 8));
+    else if (i < 6)
+        f->axes[i - 2] = (int8_t)v;
+    else
+        f->hat = v;
+}
+
+/* 空闲帧: 无按键、摇杆居中 */
+static void frame_neutral(macro_frame_t *f)
+{
+    memset(f, 0, sizeof(*f));
+    f->hat = GAMEPAD_HAT_CENTER;
+}
+
+/* 写入变长整数 */
+static void rec_put_varint(uint32_t v)
+{
+    while (v >= 0x80)
+    {
+        rec_buf.raw[rec_pos++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    rec_buf.raw[rec_pos++] = (uint8_t)v;
+}
+
+/* 写入一个事件 */
+static void rec_put_event(uint32_t tick, uint8_t mask, const uint8_t fields[MACRO_FIELDS])
+{
+    rec_put_varint(tick - rec_last_tick);
+    rec_buf.raw[rec_pos++] = mask;
+    for (uint8_t i = 0; i < MACRO_FIELDS; i++)
+    {
+        if (mask & (1u << i))
+            rec_buf.raw[rec_pos++] = fields[i];
+    }
+
+    rec_last_tick = tick;
+    if (mask)
+        rec_buf.hdr.events++;
+}
+
+/* 结束录制: 写入结束标记并填写头部 */
+static void rec_finish(uint32_t tick)
+{
+    uint32_t sum = 0;
+
+    rec_put_event(tick, 0, RT_NULL);
+
+    for (uint32_t i = sizeof(macro_header_t); i < rec_pos; i++)
+        sum += rec_buf.raw[i];
+
+    rec_buf.hdr.magic = MACRO_MAGIC;
+    rec_buf.hdr.version = MACRO_VERSION;
+    rec_buf.hdr.size = rec_pos - sizeof(macro_header_t);
+    rec_buf.hdr.duration = tick - rec_start_tick;
+    rec_buf.hdr.checksum = sum;
+    rec_valid = true;
+
+    macro_state = MACRO_IDLE;
+}
+
+/* 轴值是否需要记录: 偏离上次记录超过死区，或到达中心/满行程(保证回放时这些位置准确) */
+static bool rec_axis_changed(int8_t now, int8_t prev)
+{
+    if (now == prev)
+        return false;
+    if (now == 0 || abs(now) >= INT8_MAX)
+        return true;
+
+    return abs(now - prev) > MACRO_AXIS_DEADBAND;
+}
+
+/* 录制一个节拍 */
+static void rec_step(uint32_t tick, const macro_frame_t *frame)
+{
+    uint8_t now[MACRO_FIELDS], prev[MACRO_FIELDS];
+    uint8_t mask = 0;
+
+    frame_fields(frame, now);
+    frame_fields(&rec_prev, prev);
+    for (uint8_t i = 0; i < MACRO_FIELDS; i++)
+    {
+        bool changed = (i >= 2 && i < 6) ? rec_axis_changed((int8_t)now[i], (int8_t)prev[i])
+                                         : now[i] != prev[i];
+
+        if (changed)
+            mask |= (uint8_t)(1u << i);
+    }
+
+    if (mask == 0)
+        return;
+
+    /* 保留结束标记的空间，写满时自动结束 */
+    if (rec_pos + MACRO_EVENT_MAX * 2 > MACRO_SLOT_SIZE)
+    {
+        rec_truncated = true;
+        rec_finish(tick);
+        return;
+    }
+
+    rec_put_event(tick, mask, now);
+
+    /* 只更新记录了的字段，死区内的轴仍与上次记录的值比较，缓慢移动不会被漏掉 */
+    for (uint8_t i = 0; i < MACRO_FIELDS; i++)
+    {
+        if (mask & (1u << i))
+            frame_set_field(&rec_prev, i, now[i]);
+    }
+}
+
+/* ================ 解码 ================ */
+
+/* 读取变长整数，越界时返回false */
+static bool play_get_varint(uint32_t *v)
+{
+    uint32_t shift = 0;
+
+    *v = 0;
+    while (play_ptr < play_end && shift < 32)
+    {
+        uint8_t b = *play_ptr++;
+
+        *v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return true;
+        shift += 7;
+    }
+
+    return false;
+}
+
+/* 校验宏 */
+static bool macro_valid(const macro_header_t *hdr)
+{
+    const uint8_t *data = (const uint8_t *)(hdr + 1);
+    uint32_t sum = 0;
+
+    if (hdr->magic != MACRO_MAGIC || hdr->version != MACRO_VERSION ||
+        hdr->size > MACRO_SLOT_SIZE - sizeof(macro_header_t) ||
+        hdr->period_us == 0 || hdr->duration == 0)
+        return false;
+
+    for (uint32_t i = 0; i < hdr->size; i++)
+        sum += data[i];
+
+    return sum == hdr->checksum;
+}
+
+/* 回放一个节拍，返回输出是否改变 */
+static bool play_step(uint32_t tick)
+{
+    uint32_t elapsed_us = (tick - play_start_tick) * loop_timer_period();
+    uint32_t dt;
+    uint8_t mask;
+    bool changed = false;
+
+    /* 两个时间都按32位模运算累加，无限循环回放约71分钟后回绕，须按差值比较 */
+    while ((int32_t)(elapsed_us - play_due_us) >= 0)
+    {
+        if (play_ptr >= play_end)
+            goto finish;
+
+        mask = *play_ptr++;
+        if (mask == 0)
+        {
+            /* 一遍结束，继续下一遍时时间基准连续累加，不引入误差 */
+            if (play_loops == 1)
+                goto finish;
+            if (play_loops > 1)
+                play_loops--;
+            play_ptr = (const uint8_t *)(play_hdr + 1);
+        }
+        else
+        {
+            for (uint8_t i = 0; i < MACRO_FIELDS; i++)
+            {
+                if ((mask & (1u << i)) && play_ptr < play_end)
+                    frame_set_field(&play_frame, i, *play_ptr++);
+            }
+            changed = true;
+        }
+
+        if (!play_get_varint(&dt))
+            goto finish;
+        play_due_us += dt * play_hdr->period_us;
+    }
+
+    return changed;
+
+finish:
+    macro_state = MACRO_IDLE;
+    return true;
+}
+
+/* ================ 公共API ================ */
+
+/* 在输入循环中每个节拍调用一次 */
+bool macro_process(uint32_t tick, macro_frame_t *frame)
+{
+    uint8_t fields[MACRO_FIELDS];
+    uint8_t req = macro_req;
+    uint32_t dt;
+    bool changed = false;
+
+    if (req != MACRO_REQ_NONE)
+    {
+        macro_req = MACRO_REQ_NONE;
+
+        if (macro_state == MACRO_RECORDING)
+            rec_finish(tick);
+        if (macro_state == MACRO_PLAYING)
+        {
+            macro_state = MACRO_IDLE;
+            changed = true;
+        }
+
+        if (req == MACRO_REQ_RECORD)
+        {
+            /* 第一个事件记录完整的初始状态 */
+            memset(&rec_buf.hdr, 0, sizeof(rec_buf.hdr));
+            rec_buf.hdr.period_us = (uint16_t)loop_timer_period();
+            rec_pos = sizeof(macro_header_t);
+            rec_start_tick = tick;
+            rec_last_tick = tick;
+            rec_valid = false;
+            rec_truncated = false;
+            rec_prev = *frame;
+            frame_fields(frame, fields);
+            rec_put_event(tick, MACRO_MASK_ALL, fields);
+            macro_state = MACRO_RECORDING;
+            return changed;
+        }
+        else if (req == MACRO_REQ_PLAY)
+        {
+            play_ptr = (const uint8_t *)(play_hdr + 1);
+            play_end = play_ptr + play_hdr->size;
+            play_loops = play_loops_req;
+            play_start_tick = tick;
+            frame_neutral(&play_frame);
+            if (play_get_varint(&dt))
+            {
+                play_due_us = dt * play_hdr->period_us;
+                macro_state = MACRO_PLAYING;
+            }
+        }
+    }
+
+    if (macro_state == MACRO_RECORDING)
+    {
+        rec_step(tick, frame);
+    }
+    else if (macro_state == MACRO_PLAYING)
+    {
+        changed |= play_step(tick);
+        if (macro_state == MACRO_PLAYING)
+            *frame = play_frame;
+    }
+
+    return changed;
+}
+
+/* 是否正在录制或回放 */
+bool macro_is_active(void)
+{
+    return macro_state != MACRO_IDLE || macro_req != MACRO_REQ_NONE;
+}
+
+/* 开始录制 */
+rt_err_t macro_record_start(void)
+{
+    if (macro_is_active())
+        return -RT_EBUSY;
+    if (loop_timer_period() == 0 || loop_timer_period() > 0xFFFF)
+        return -RT_ERROR;
+
+    macro_req = MACRO_REQ_RECORD;
+    return RT_EOK;
+}
+
+/* 开始回放 */
+rt_err_t macro_play_start(uint8_t slot, uint32_t loops)
+{
+    const macro_header_t *hdr;
+
+    if (macro_is_active())
+        return -RT_EBUSY;
+
+    if (slot == MACRO_SLOT_RAM)
+    {
+        if (!rec_valid)
+            return -RT_EEMPTY;
+        hdr = &rec_buf.hdr;
+    }
+    else if (slot < MACRO_SLOTS)
+        hdr = (const macro_header_t *)MACRO_SLOT_ADDR(slot);
+    else
+        return -RT_EINVAL;
+
+    if (!macro_valid(hdr))
+        return -RT_EEMPTY;
+
+    play_hdr = hdr;
+    play_loops_req = loops;
+    macro_req = MACRO_REQ_PLAY;
+    return RT_EOK;
+}
+
+/* 停止录制或回放 */
+void macro_stop(void)
+{
+    if (macro_state != MACRO_IDLE)
+        macro_req = MACRO_REQ_STOP;
+}
+
+/* 保存到flash槽位 */
+rt_err_t macro_save(uint8_t slot)
+{
+    uint32_t size;
+    rt_err_t ret;
+
+    if (slot >= MACRO_SLOTS)
+        return -RT_EINVAL;
+    if (macro_is_active())
+        return -RT_EBUSY;
+    if (!rec_valid)
+        return -RT_EEMPTY;
+
+    size = sizeof(macro_header_t) + rec_buf.hdr.size;
+    size = (size + FLASH_STORE_PHRASE_SIZE - 1) / FLASH_STORE_PHRASE_SIZE * FLASH_STORE_PHRASE_SIZE;
+
+    ret = flash_store_erase(MACRO_SLOT_ADDR(slot), MACRO_SLOT_SIZE);
+    if (ret == RT_EOK)
+        ret = flash_store_program(MACRO_SLOT_ADDR(slot), rec_buf.raw, size);
+
+    return ret;
+}
+
+/* 擦除flash槽位 */
+rt_err_t macro_erase(uint8_t slot)
+{
+    if (slot >= MACRO_SLOTS)
+        return -RT_EINVAL;
+    if (macro_is_active() && play_hdr == (const macro_header_t *)MACRO_SLOT_ADDR(slot))
+        return -RT_EBUSY;
+
+    return flash_store_erase(MACRO_SLOT_ADDR(slot), MACRO_SLOT_SIZE);
+}
+
+/* ================ 调试命令 ================ */
+
+static void macro_print(const char *name, const macro_header_t *hdr)
+{
+    if (!macro_valid(hdr))
+    {
+        rt_kprintf("%-4s: empty\n", name);
+        return;
+    }
+
+    rt_kprintf("%-4s: %d ms, %d events, %d bytes, tick %d us\n", name,
+               hdr->duration * hdr->period_us / 1000, hdr->events, hdr->size, hdr->period_us);
+}
+
+static int macro(int argc, char **argv)
+{
+    static const char *const state_names[] = {"idle", "recording", "playing"};
+    char name[4];
+    rt_err_t ret = RT_EOK;
+    uint8_t slot;
+
+    if (argc < 2 || rt_strcmp(argv[1], "list") == 0)
+    {
+        rt_kprintf("state: %s%s\n", state_names[macro_state], rec_truncated ? " (last recording truncated)" : "");
+        macro_print("ram", &rec_buf.hdr);
+        for (slot = 0; slot < MACRO_SLOTS; slot++)
+        {
+            rt_snprintf(name, sizeof(name), "%d", slot);
+            macro_print(name, (const macro_header_t *)MACRO_SLOT_ADDR(slot));
+        }
+        return 0;
+    }
+
+    slot = (argc > 2 && rt_strcmp(argv[2], "ram") != 0) ? (uint8_t)atoi(argv[2]) : MACRO_SLOT_RAM;
+
+    if (rt_strcmp(argv[1], "rec") == 0)
+        ret = macro_record_start();
+    else if (rt_strcmp(argv[1], "stop") == 0)
+        macro_stop();
+    else if (rt_strcmp(argv[1], "play") == 0)
+        ret = macro_play_start(slot, (argc > 3) ? (uint32_t)atoi(argv[3]) : 1);
+    else if (rt_strcmp(argv[1], "save") == 0 && argc > 2)
+        ret = macro_save(slot);
+    else if (rt_strcmp(argv[1], "erase") == 0 && argc > 2)
+        ret = macro_erase(slot);
+    else
+    {
+        rt_kprintf("usage: macro [list | rec | stop | play [slot|ram] [loops] | save <slot> | erase <slot>]\n");
+        return -1;
+    }
+
+    if (ret != RT_EOK)
+    {
+        rt_kprintf("macro: %s failed (%d)\n", argv[1], ret);
+        return -1;
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(macro, input macro: macro [list | rec | stop | play [slot|ram] [loops] | save <slot> | erase <slot>]);
@@ -0,0 +1,105 @@
+/**
+ * @file macro.h
+ * @brief 输入宏录制与回放
+ * @details 在输入循环的每个节拍记录报告内容(按钮、四轴、方向键)，录制时即编码为增量格式:
+ *          只保存发生变化的字段和距上一事件的节拍数，摇杆轴的小幅抖动按死区忽略。宏可保存到flash槽位，
+ *          回放直接从flash读取，不分配内存，按节拍序号定时，与报告同速率输出
+ *
+ * 数据格式:
+ *   macro_header_t
+ *   事件流，每个事件: dt(变长整数，节拍数) + mask(1) + 变化的字段
+ *     mask bit0/1: 按钮低/高字节，bit2-5: LX LY RX RY，bit6: 方向键
+ *     mask为0表示结束，dt为最后一个事件后保持的时长
+ */
+
+#ifndef __MACRO_H__
+#define __MACRO_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_store.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ================ 配置参数 ================ */
+
+#define MACRO_SLOTS         FLASH_STORE_MACRO_SLOTS
+#define MACRO_SLOT_SIZE     (FLASH_STORE_MACRO_SLOT_SECTORS * FLASH_STORE_SECTOR_SIZE)  /* 含头部 */
+#define MACRO_MAGIC         0x43414D47u                 /* "GMAC" */
+#define MACRO_VERSION       1
+#define MACRO_SLOT_RAM      0xFF                        /* 回放RAM中刚录制的宏 */
+#define MACRO_AXIS_DEADBAND 1                           /* 录制时轴值变化不超过此值视为抖动不记录，回中和满行程除外 */
+
+/* 一个节拍的输出内容 */
+typedef struct {
+    uint16_t buttons;
+    int8_t axes[4];         /* LX LY RX RY */
+    uint8_t hat;
+} macro_frame_t;
+
+/* 宏头部 */
+typedef struct {
+    uint32_t magic;         /* MACRO_MAGIC */
+    uint16_t version;       /* MACRO_VERSION */
+    uint16_t period_us;     /* 录制时的节拍周期 */
+    uint32_t size;          /* 事件流字节数 */
+    uint32_t duration;      /* 总时长(节拍) */
+    uint32_t events;        /* 事件数 */
+    uint32_t checksum;      /* 事件流逐字节累加和 */
+    uint32_t reserved[2];   /* 补齐到编程单位 */
+} macro_header_t;
+
+/**
+ * @brief 在输入循环中每个节拍调用一次
+ * @param tick 当前节拍序号
+ * @param frame 输入为本节拍生成的内容；回放时被替换为宏的内容
+ * @return true表示回放改变了输出，即使输入本身没有变化也需要发送报告
+ */
+bool macro_process(uint32_t tick, macro_frame_t *frame);
+
+/**
+ * @brief 是否正在录制或回放，期间调用方不应让输入进入休眠
+ */
+bool macro_is_active(void);
+
+/**
+ * @brief 开始录制到RAM，在下一个节拍生效
+ * @return RT_EOK成功，-RT_EBUSY正在录制或回放
+ */
+rt_err_t macro_record_start(void);
+
+/**
+ * @brief 开始回放，在下一个节拍生效
+ * @param slot 槽位号或MACRO_SLOT_RAM
+ * @param loops 回放次数，0表示无限循环
+ * @return RT_EOK成功，-RT_EEMPTY槽位无有效宏
+ */
+rt_err_t macro_play_start(uint8_t slot, uint32_t loops);
+
+/**
+ * @brief 停止录制或回放，在下一个节拍生效
+ */
+void macro_stop(void);
+
+/**
+ * @brief 把RAM中录制的宏保存到flash槽位
+ * @param slot 槽位号
+ * @return RT_EOK成功
+ */
+rt_err_t macro_save(uint8_t slot);
+
+/**
+ * @brief 擦除flash槽位
+ * @param slot 槽位号
+ * @return RT_EOK成功
+ */
+rt_err_t macro_erase(uint8_t slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MACRO_H__ */
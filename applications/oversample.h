@@ -0,0 +1,70 @@
+/**
+ * @file oversample.h
+ * @brief 摇杆过采样: 对最近若干帧4轴原始值求boxcar平均
+ * @details 只做累加和取整，不涉及硬件，固件读取环形缓冲区和主机测试回放采集数据共用
+ */
+
+#ifndef __OVERSAMPLE_H__
+#define __OVERSAMPLE_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ================ 配置参数 ================ */
+
+#define OVERSAMPLE_AXES     4
+#define OVERSAMPLE_FRAMES   4       /* 2kHz采样时为2ms窗口 */
+
+/* 累加器 */
+typedef struct {
+    uint32_t sum[OVERSAMPLE_AXES];
+    uint32_t count;
+} oversample_t;
+
+/**
+ * @brief 清空累加器
+ */
+rt_inline void oversample_reset(oversample_t *os)
+{
+    for (uint32_t i = 0; i < OVERSAMPLE_AXES; i++)
+        os->sum[i] = 0;
+    os->count = 0;
+}
+
+/**
+ * @brief 累加一帧
+ * @param frame 4轴原始值 (16位)
+ */
+rt_inline void oversample_add(oversample_t *os, const uint32_t frame[OVERSAMPLE_AXES])
+{
+    for (uint32_t i = 0; i < OVERSAMPLE_AXES; i++)
+        os->sum[i] += frame[i];
+    os->count++;
+}
+
+/**
+ * @brief 输出四舍五入后的平均值
+ * @param frame 输出4轴平均值
+ * @return false表示没有累加任何帧
+ */
+rt_inline bool oversample_get(const oversample_t *os, uint32_t frame[OVERSAMPLE_AXES])
+{
+    if (os->count == 0)
+        return false;
+
+    for (uint32_t i = 0; i < OVERSAMPLE_AXES; i++)
+        frame[i] = (os->sum[i] + os->count / 2) / os->count;
+
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __OVERSAMPLE_H__ */
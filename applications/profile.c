@@ -0,0 +1,491 @@
+/**
+ * @file profile.c
+ * @brief 调参配置档案实现
+ * @details 所有槽位共用一个扇区。保存或删除时把其余有效记录暂存到RAM，
+ *          擦除扇区后重新写入；重写期间当前配置临时指向RAM副本，输入线程读到的内容不变。
+ *          CRC32使用CRC0硬件计算(与以太网/zlib相同的参数)
+ */
+
+#include "profile.h"
+#include "gamepad_app.h"
+#include "loop_timer.h"
+#include <board.h>
+#include <rthw.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fsl_crc.h"
+
+/* ================ 内部定义 ================ */
+
+/* 记录长度须为编程单位的整数倍，且不超过槽位间距 */
+typedef char profile_size_check[(sizeof(profile_t) % FLASH_STORE_PHRASE_SIZE == 0 &&
+                                 sizeof(profile_t) <= PROFILE_SLOT_SIZE) ? 1 : -1];
+
+#define PROFILE_SLOT_ADDR(slot)  (FLASH_STORE_PROFILE_ADDR + (uint32_t)(slot) * PROFILE_SLOT_SIZE)
+#define PROFILE_CRC_LEN          offsetof(profile_t, crc)
+
+#define REMAP_ROW_BASE  {REMAP_BASE, REMAP_BASE, REMAP_BASE, REMAP_BASE, \
+                         REMAP_BASE, REMAP_BASE, REMAP_BASE, REMAP_BASE, \
+                         REMAP_BASE, REMAP_BASE, REMAP_BASE, REMAP_BASE, \
+                         REMAP_BASE, REMAP_BASE, REMAP_BASE, REMAP_BASE}
+
+/* 内置默认配置，与各模块的编译期默认值一致 */
+static const profile_t profile_builtin = {
+    .magic = PROFILE_MAGIC,
+    .version = PROFILE_VERSION,
+    .size = sizeof(profile_t),
+    .name = "default",
+    .shape = {
+        {STICK_CURVE_LINEAR, 0, STICK_SHAPE_INNER_DEFAULT, STICK_SHAPE_OUTER_DEFAULT, 0},
+        {STICK_CURVE_LINEAR, 0, STICK_SHAPE_INNER_DEFAULT, STICK_SHAPE_OUTER_DEFAULT, 0},
+    },
+    .filter = {AXIS_FILTER_MIN_CUTOFF_MHZ, AXIS_FILTER_BETA_MHZ, AXIS_FILTER_D_CUTOFF_MHZ},
+    .change_threshold = GAMEPAD_AXIS_THRESHOLD,
+    .loop_period_us = GAMEPAD_LOOP_PERIOD_US,
+    .remap = {
+        {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+        REMAP_ROW_BASE, REMAP_ROW_BASE, REMAP_ROW_BASE,
+    },
+    .remap_fn = {REMAP_NONE, REMAP_NONE, REMAP_NONE, REMAP_NONE},
+    .dpad_keys = {DPAD_KEY_UP_DEFAULT, DPAD_KEY_DOWN_DEFAULT, DPAD_KEY_LEFT_DEFAULT, DPAD_KEY_RIGHT_DEFAULT},
+    .dpad_socd = DPAD_SOCD_DEFAULT,
+};
+
+/* ================ 内部变量 ================ */
+
+static const profile_t *volatile active = &profile_builtin;
+static const profile_t *volatile pending = RT_NULL;
+static uint8_t active_slot = PROFILE_DEFAULT;
+static uint8_t pending_slot = PROFILE_DEFAULT;
+
+static profile_t shadow;                    /* flash重写期间当前配置的RAM副本 */
+static profile_t stage[PROFILE_SLOTS];      /* flash重写期间各槽位的暂存 */
+static bool stage_used[PROFILE_SLOTS];
+
+static struct rt_mutex profile_lock;        /* 保护CRC0、flash重写和切换状态 */
+
+/* ================ 内部函数 ================ */
+
+/* 计算记录的CRC32 */
+static uint32_t profile_crc(const profile_t *p)
+{
+    crc_config_t config;
+
+    config.polynomial = 0x04C11DB7U;
+    config.seed = 0xFFFFFFFFU;
+    config.reflectIn = true;
+    config.reflectOut = true;
+    config.complementChecksum = true;
+    config.crcBits = kCrcBits32;
+    config.crcResult = kCrcFinalChecksum;
+
+    CRC_Init(CRC0, &config);
+    CRC_WriteData(CRC0, (const uint8_t *)p, PROFILE_CRC_LEN);
+
+    return CRC_Get32bitResult(CRC0);
+}
+
+/* 检查参数范围，保证切换时各模块都能接受 */
+static bool profile_check(const profile_t *p)
+{
+    const stick_shape_config_t *s;
+
+    for (uint8_t i = 0; i < STICK_NUM; i++)
+    {
+        s = &p->shape[i];
+        if (s->curve >= STICK_CURVE_NUM || s->strength > 100 ||
+            s->outer > 32767 || s->inner >= s->outer || s->anti > 32767)
+            return false;
+    }
+
+    if (p->loop_period_us < LOOP_TIMER_PERIOD_MIN_US || p->loop_period_us > LOOP_TIMER_PERIOD_MAX_US)
+        return false;
+
+    for (uint8_t l = 0; l < REMAP_LAYERS; l++)
+    {
+        for (uint8_t i = 0; i < REMAP_KEYS; i++)
+        {
+            uint8_t dst = p->remap[l][i];
+
+            if (dst >= 16 && dst != REMAP_NONE && !(dst == REMAP_BASE && l > 0))
+                return false;
+        }
+        if (l > 0 && p->remap_fn[l] >= REMAP_KEYS && p->remap_fn[l] != REMAP_NONE)
+            return false;
+    }
+
+    for (uint8_t d = 0; d < DPAD_DIRS; d++)
+    {
+        if (p->dpad_keys[d] >= 16 && p->dpad_keys[d] != DPAD_KEY_NONE)
+            return false;
+    }
+    if (p->dpad_socd >= DPAD_SOCD_NUM)
+        return false;
+
+    return p->name[PROFILE_NAME_LEN - 1] == '\0';
+}
+
+/* 检查记录是否完整有效，调用方持有profile_lock */
+static bool profile_valid(const profile_t *p)
+{
+    return p->magic == PROFILE_MAGIC &&
+           p->version == PROFILE_VERSION &&
+           p->size == sizeof(profile_t) &&
+           p->crc == profile_crc(p) &&
+           profile_check(p);
+}
+
+/*
+ * 在调用方线程预先生成配置的查找表(摇杆曲线、按键映射)并设为等待切换，
+ * 输入线程应用时只交换指针。调用方持有profile_lock，与profile_poll互斥
+ */
+static rt_err_t profile_stage(const profile_t *p, uint8_t slot)
+{
+    if (stick_shape_prepare(STICK_LEFT, &p->shape[STICK_LEFT]) != RT_EOK ||
+        stick_shape_prepare(STICK_RIGHT, &p->shape[STICK_RIGHT]) != RT_EOK ||
+        remap_prepare(p->remap, p->remap_fn) != RT_EOK)
+        return -RT_EINVAL;
+
+    pending_slot = slot;
+    pending = p;
+
+    return RT_EOK;
+}
+
+/* 从当前运行的各模块参数生成记录 */
+static void profile_capture(profile_t *p, const char *name, uint16_t change_threshold)
+{
+    const profile_t *cur = active;
+
+    memset(p, 0, sizeof(*p));
+    p->magic = PROFILE_MAGIC;
+    p->version = PROFILE_VERSION;
+    p->size = sizeof(profile_t);
+    strncpy(p->name, name != RT_NULL ? name : cur->name, PROFILE_NAME_LEN - 1);
+
+    p->shape[STICK_LEFT] = *stick_shape_get(STICK_LEFT);
+    p->shape[STICK_RIGHT] = *stick_shape_get(STICK_RIGHT);
+    p->filter = *axis_filter_get_config();
+    p->change_threshold = change_threshold ? change_threshold : cur->change_threshold;
+    p->loop_period_us = gamepad_get_loop_period();
+
+    for (uint8_t l = 0; l < REMAP_LAYERS; l++)
+    {
+        remap_get_layer(l, p->remap[l]);
+        p->remap_fn[l] = remap_get_fn(l);
+    }
+    dpad_get_keys(p->dpad_keys);
+    p->dpad_socd = dpad_get_socd();
+
+    for (uint8_t b = 0; b < 16; b++)
+        gamepad_get_turbo(b, &p->turbo_on_ms[b], &p->turbo_off_ms[b]);
+
+    p->crc = profile_crc(p);
+}
+
+/*
+ * 重写整个扇区: target槽位写入rec，rec为RT_NULL表示删除该槽位。
+ * 调用方持有profile_lock，输入线程期间不会应用切换
+ */
+static rt_err_t profile_rewrite(uint8_t target, const profile_t *rec)
+{
+    const profile_t *cur = active;
+    bool cur_in_sector = (cur != &shadow && cur != &profile_builtin);
+    rt_err_t ret;
+
+    for (uint8_t i = 0; i < PROFILE_SLOTS; i++)
+    {
+        const profile_t *p = (const profile_t *)PROFILE_SLOT_ADDR(i);
+
+        stage_used[i] = (i != target) && profile_valid(p);
+        if (stage_used[i])
+            stage[i] = *p;
+    }
+    if (rec != RT_NULL)
+    {
+        stage[target] = *rec;
+        stage_used[target] = true;
+    }
+
+    /* 当前配置在本扇区内时先切到RAM副本，内容相同 */
+    if (cur_in_sector)
+    {
+        shadow = *cur;
+        active = &shadow;
+    }
+
+    ret = flash_store_erase(FLASH_STORE_PROFILE_ADDR, FLASH_STORE_SECTOR_SIZE);
+    for (uint8_t i = 0; i < PROFILE_SLOTS && ret == RT_EOK; i++)
+    {
+        if (stage_used[i])
+            ret = flash_store_program(PROFILE_SLOT_ADDR(i), &stage[i], sizeof(profile_t));
+    }
+
+    if (cur_in_sector)
+    {
+        if (active_slot == target || ret != RT_EOK)
+        {
+            /* 内容已改变或写入失败: 继续使用RAM副本，保存成功时重新切换 */
+            if (ret == RT_EOK)
+                ret = profile_stage((const profile_t *)PROFILE_SLOT_ADDR(target), target);
+        }
+        else
+        {
+            active = cur;
+        }
+    }
+
+    return ret;
+}
+
+/* ================ 公共API ================ */
+
+/* 获取当前生效的配置 */
+const profile_t *profile_get(void)
+{
+    return active;
+}
+
+/* 输入线程应用等待中的切换 */
+const profile_t *profile_poll(void)
+{
+    const profile_t *p;
+
+    if (pending == RT_NULL)
+        return RT_NULL;
+
+    /* flash正在重写时推迟到下一个周期，不等待 */
+    if (rt_mutex_take(&profile_lock, 0) != RT_EOK)
+        return RT_NULL;
+
+    /* 查找表已在切换方线程生成，这里只交换指针；映射正被命令修改时同样推迟 */
+    p = pending;
+    if (p != RT_NULL && remap_commit() != RT_EOK)
+        p = RT_NULL;
+
+    if (p != RT_NULL)
+    {
+        pending = RT_NULL;
+        stick_shape_commit();
+        axis_filter_set_config(&p->filter);
+        dpad_set_keys(p->dpad_keys);
+        dpad_set_socd(p->dpad_socd);
+
+        active = p;
+        active_slot = pending_slot;
+    }
+
+    rt_mutex_release(&profile_lock);
+
+    return p;
+}
+
+/* 切换配置 */
+rt_err_t profile_select(uint8_t slot)
+{
+    const profile_t *p;
+    rt_err_t ret;
+
+    if (slot == PROFILE_DEFAULT)
+        p = &profile_builtin;
+    else if (slot >= PROFILE_SLOTS)
+        return -RT_EINVAL;
+    else if ((p = profile_slot(slot)) == RT_NULL)
+        return -RT_EEMPTY;
+
+    rt_mutex_take(&profile_lock, RT_WAITING_FOREVER);
+    ret = profile_stage(p, slot);
+    rt_mutex_release(&profile_lock);
+
+    return ret;
+}
+
+/* 当前配置所在槽位 */
+uint8_t profile_active_slot(void)
+{
+    return active_slot;
+}
+
+/* 读取槽位中的有效配置 */
+const profile_t *profile_slot(uint8_t slot)
+{
+    const profile_t *p;
+    bool valid;
+
+    if (slot >= PROFILE_SLOTS)
+        return RT_NULL;
+
+    p = (const profile_t *)PROFILE_SLOT_ADDR(slot);
+
+    rt_mutex_take(&profile_lock, RT_WAITING_FOREVER);
+    valid = profile_valid(p);
+    rt_mutex_release(&profile_lock);
+
+    return valid ? p : RT_NULL;
+}
+
+/* 把当前运行中的参数保存到槽位 */
+rt_err_t profile_save(uint8_t slot, const char *name, uint16_t change_threshold)
+{
+    static profile_t rec;
+    rt_err_t ret;
+
+    if (slot >= PROFILE_SLOTS)
+        return -RT_EINVAL;
+
+    rt_mutex_take(&profile_lock, RT_WAITING_FOREVER);
+    profile_capture(&rec, name, change_threshold);
+    ret = profile_rewrite(slot, &rec);
+    rt_mutex_release(&profile_lock);
+
+    return ret;
+}
+
+/* 删除槽位中的配置 */
+rt_err_t profile_erase(uint8_t slot)
+{
+    rt_err_t ret;
+
+    if (slot >= PROFILE_SLOTS)
+        return -RT_EINVAL;
+
+    rt_mutex_take(&profile_lock, RT_WAITING_FOREVER);
+    if (slot == active_slot || (pending != RT_NULL && slot == pending_slot))
+        ret = -RT_EBUSY;
+    else
+        ret = profile_rewrite(slot, RT_NULL);
+    rt_mutex_release(&profile_lock);
+
+    return ret;
+}
+
+static int profile_init(void)
+{
+    rt_mutex_init(&profile_lock, "profile", RT_IPC_FLAG_PRIO);
+
+    /* 启动槽位有效时由输入线程在第一个周期加载 */
+    if (profile_select(PROFILE_BOOT_SLOT) == RT_EOK)
+        rt_kprintf("profile: slot %d '%s' loaded\n", PROFILE_BOOT_SLOT, pending->name);
+
+    return 0;
+}
+INIT_ENV_EXPORT(profile_init);
+
+/* ================ 调试命令 ================ */
+
+/* 解析槽位号: 数字或default */
+static int profile_parse_slot(const char *s, uint8_t *slot)
+{
+    if (rt_strcmp(s, "default") == 0)
+        *slot = PROFILE_DEFAULT;
+    else if (*s >= '0' && *s <= '9' && atoi(s) < PROFILE_SLOTS)
+        *slot = (uint8_t)atoi(s);
+    else
+        return -1;
+
+    return 0;
+}
+
+static void profile_list(void)
+{
+    const profile_t *p;
+    uint8_t cur = active_slot;
+
+    rt_kprintf("%c  -  %-16s (built in)\n", cur == PROFILE_DEFAULT ? '*' : ' ', profile_builtin.name);
+    for (uint8_t i = 0; i < PROFILE_SLOTS; i++)
+    {
+        p = profile_slot(i);
+        if (p != RT_NULL)
+        {
+            rt_kprintf("%c %2d  %-16s period %d us, threshold %d\n", i == cur ? '*' : ' ', i,
+                       p->name, p->loop_period_us, p->change_threshold);
+        }
+        else if (((const profile_t *)PROFILE_SLOT_ADDR(i))->magic == PROFILE_MAGIC)
+        {
+            rt_kprintf("  %2d  <invalid>\n", i);
+        }
+        else
+        {
+            rt_kprintf("  %2d  <empty>\n", i);
+        }
+    }
+}
+
+static void profile_show(const profile_t *p)
+{
+    static const char *const curve_names[STICK_CURVE_NUM] = {"linear", "expo", "scurve"};
+    uint16_t turbo = 0;
+
+    rt_kprintf("profile '%s'\n", p->name);
+    for (uint8_t i = 0; i < STICK_NUM; i++)
+    {
+        rt_kprintf("  %s stick: %s %d%%, deadzone %d-%d, anti %d\n", i == STICK_LEFT ? "left" : "right",
+                   curve_names[p->shape[i].curve], p->shape[i].strength,
+                   p->shape[i].inner, p->shape[i].outer, p->shape[i].anti);
+    }
+    rt_kprintf("  filter: min_cutoff %d mHz, beta %d mHz, d_cutoff %d mHz\n",
+               p->filter.min_cutoff_mhz, p->filter.beta_mhz, p->filter.d_cutoff_mhz);
+    rt_kprintf("  change threshold %d, loop period %d us\n", p->change_threshold, p->loop_period_us);
+    for (uint8_t l = 1; l < REMAP_LAYERS; l++)
+    {
+        if (p->remap_fn[l] < REMAP_KEYS)
+            rt_kprintf("  layer %d on fn key %d\n", l, p->remap_fn[l]);
+    }
+    for (uint8_t b = 0; b < 16; b++)
+    {
+        if (p->turbo_on_ms[b])
+            turbo |= (uint16_t)(1u << b);
+    }
+    rt_kprintf("  dpad keys %d %d %d %d, socd mode %d\n", p->dpad_keys[DPAD_UP], p->dpad_keys[DPAD_DOWN],
+               p->dpad_keys[DPAD_LEFT], p->dpad_keys[DPAD_RIGHT], p->dpad_socd);
+    rt_kprintf("  turbo buttons 0x%04X\n", turbo);
+}
+
+static int profile(int argc, char **argv)
+{
+    uint8_t slot;
+    rt_err_t ret;
+
+    if (argc < 2 || rt_strcmp(argv[1], "list") == 0)
+    {
+        profile_list();
+        return 0;
+    }
+
+    if (rt_strcmp(argv[1], "show") == 0)
+    {
+        profile_show(profile_get());
+        return 0;
+    }
+
+    if (argc < 3 || profile_parse_slot(argv[2], &slot) != 0)
+    {
+        rt_kprintf("usage: profile [list | show | use <slot|default> | save <slot> [name] [threshold] | erase <slot>]\n");
+        return -1;
+    }
+
+    if (rt_strcmp(argv[1], "use") == 0)
+    {
+        ret = profile_select(slot);
+        rt_kprintf("profile use %s\n", ret == RT_EOK ? "OK" : "failed (empty slot)");
+    }
+    else if (rt_strcmp(argv[1], "save") == 0 && slot != PROFILE_DEFAULT)
+    {
+        ret = profile_save(slot, argc > 3 ? argv[3] : RT_NULL, argc > 4 ? (uint16_t)atoi(argv[4]) : 0);
+        rt_kprintf("profile save %s\n", ret == RT_EOK ? "OK" : "failed");
+    }
+    else if (rt_strcmp(argv[1], "erase") == 0 && slot != PROFILE_DEFAULT)
+    {
+        ret = profile_erase(slot);
+        rt_kprintf("profile erase %s\n", ret == RT_EOK ? "OK" : (ret == -RT_EBUSY ? "failed (in use)" : "failed"));
+    }
+    else
+    {
+        rt_kprintf("unknown option: %s\n", argv[1]);
+        return -1;
+    }
+
+    return ret == RT_EOK ? 0 : -1;
+}
+MSH_CMD_EXPORT(profile, tuning profiles: profile [list | show | use <slot|default> | save <slot> [name] [threshold] | erase <slot>]);
@@ -0,0 +1,118 @@
+/**
+ * @file profile.h
+ * @brief 调参配置档案
+ * @details 多套完整的调参配置(摇杆死区和曲线、滤波、变化阈值、循环周期、按键映射、方向键、连发)
+ *          以固定布局保存在flash的一个扇区中，每条记录带硬件CRC32校验。
+ *          切换时在调用方线程校验记录并生成摇杆曲线表和按键映射表，
+ *          输入线程在两次报告之间交换表指针、复制其余参数，整体生效；
+ *          之后每个周期只有轴变化阈值仍通过配置指针从flash读取
+ */
+
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_store.h"
+#include "stick_shape.h"
+#include "axis_filter.h"
+#include "remap.h"
+#include "dpad.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ================ 配置参数 ================ */
+
+#define PROFILE_SLOTS       FLASH_STORE_PROFILE_SLOTS
+#define PROFILE_SLOT_SIZE   (FLASH_STORE_SECTOR_SIZE / PROFILE_SLOTS)   /* 每条记录的间距 */
+#define PROFILE_MAGIC       0x46525047u     /* "GPRF" */
+#define PROFILE_VERSION     2
+#define PROFILE_NAME_LEN    16
+#define PROFILE_DEFAULT     0xFF            /* 内置默认配置，不占用槽位 */
+#define PROFILE_BOOT_SLOT   0               /* 上电时若此槽位有效则自动加载 */
+
+/*
+ * 配置记录: 固定布局，长度为编程单位的整数倍。
+ * 字段直接以各模块的配置结构保存，切换时由各模块复制或编译
+ */
+typedef struct {
+    uint32_t magic;                             /* PROFILE_MAGIC */
+    uint16_t version;                           /* PROFILE_VERSION */
+    uint16_t size;                              /* sizeof(profile_t) */
+    char name[PROFILE_NAME_LEN];                /* 以0结尾 */
+    stick_shape_config_t shape[STICK_NUM];      /* 径向死区和响应曲线 */
+    axis_filter_config_t filter;                /* 自适应滤波参数 */
+    uint16_t change_threshold;                  /* 轴变化阈值 */
+    uint16_t reserved0;
+    uint32_t loop_period_us;                    /* 自由运行时的循环周期 */
+    uint8_t remap[REMAP_LAYERS][REMAP_KEYS];    /* 各层映射 */
+    uint8_t remap_fn[REMAP_LAYERS];             /* 各层Fn键，[0]不用 */
+    uint16_t turbo_on_ms[16];                   /* 连发按下时长，0表示关闭 */
+    uint16_t turbo_off_ms[16];                  /* 连发松开时长 */
+    uint8_t dpad_keys[DPAD_DIRS];               /* 方向键按键，上下左右 */
+    uint8_t dpad_socd;                          /* dpad_socd_t */
+    uint8_t reserved1[3];
+    uint32_t reserved[1];                       /* 保留，写0 */
+    uint32_t crc;                               /* 以上所有字节的CRC32 */
+} profile_t;
+
+/**
+ * @brief 获取当前生效的配置
+ * @return 配置指针(位于flash或内置默认配置)，输入线程每个周期从中读取轴变化阈值
+ */
+const profile_t *profile_get(void);
+
+/**
+ * @brief 输入线程在每个周期开始时调用，应用等待中的切换
+ * @return 新生效的配置，没有切换或需要推迟时返回RT_NULL
+ * @note 查找表已由profile_select生成，这里只交换指针，不读取校验flash也不等待锁：
+ *       flash正在重写或按键映射正被修改时推迟到下一个周期。调用方负责应用自己使用的参数
+ */
+const profile_t *profile_poll(void);
+
+/**
+ * @brief 切换配置，在输入线程的下一个周期生效
+ * @param slot 槽位号或PROFILE_DEFAULT
+ * @return RT_EOK成功，-RT_EEMPTY槽位无有效配置，-RT_EINVAL参数超出范围
+ * @note 在调用方线程中校验并生成查找表；上一次切换尚未生效时以本次为准
+ */
+rt_err_t profile_select(uint8_t slot);
+
+/**
+ * @brief 当前配置所在槽位
+ * @return 槽位号，内置默认配置返回PROFILE_DEFAULT
+ */
+uint8_t profile_active_slot(void);
+
+/**
+ * @brief 读取槽位中的有效配置
+ * @param slot 槽位号
+ * @return 配置指针(位于flash)，无效时返回RT_NULL
+ */
+const profile_t *profile_slot(uint8_t slot);
+
+/**
+ * @brief 把当前运行中的参数保存到槽位
+ * @param slot 槽位号
+ * @param name 名称，RT_NULL时沿用当前配置的名称
+ * @param change_threshold 轴变化阈值，0表示沿用当前配置
+ * @return RT_EOK成功
+ * @note 保存到当前槽位时重新切换一次，使保存的内容完整生效
+ */
+rt_err_t profile_save(uint8_t slot, const char *name, uint16_t change_threshold);
+
+/**
+ * @brief 删除槽位中的配置
+ * @param slot 槽位号
+ * @return RT_EOK成功，-RT_EBUSY槽位正在使用
+ */
+rt_err_t profile_erase(uint8_t slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PROFILE_H__ */
@@ -0,0 +1,371 @@
+/**
+ * @file remap.c
+ * @brief 按键重映射引擎实现
+ * @details 编译好的表通过指针切换生效: 新表写入备用表后再替换层指针，
+ *          输入线程任何时候读到的都是一张完整的表。
+ *          整体切换配置时所有层先在调用方线程编译到预编译表，输入线程提交时只交换指针
+ */
+
+#include "remap.h"
+#include <rthw.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ================ 内部定义 ================ */
+
+/* 一层的编译结果 */
+typedef struct {
+    uint16_t lo[256];       /* 原始bit0-7的所有组合 */
+    uint16_t hi[256];       /* 原始bit8-15的所有组合 */
+} remap_table_t;
+
+/* ================ 内部变量 ================ */
+
+static uint8_t layer_map[REMAP_LAYERS][REMAP_KEYS];     /* 各层映射(未展开REMAP_BASE) */
+static uint8_t layer_fn[REMAP_LAYERS];                  /* 各层Fn键，层0无意义 */
+
+/* 生效的表和预编译的表各一组，另加一张单层编译用的备用表，指针在交换中轮换 */
+static remap_table_t tables[REMAP_LAYERS * 2 + 1];
+static const remap_table_t *volatile layer_table[REMAP_LAYERS] = {&tables[0], &tables[1], &tables[2], &tables[3]};
+static remap_table_t *stage_table[REMAP_LAYERS] = {&tables[4], &tables[5], &tables[6], &tables[7]};
+static remap_table_t *spare_table = &tables[REMAP_LAYERS * 2];
+static volatile uint16_t fn_mask = 0;                   /* 所有Fn键的位 */
+
+/* 上面的表指针按4层初始化，不依赖remap_init: 启动配置的预编译可能早于remap_init */
+typedef char remap_layers_check[(REMAP_LAYERS == 4) ? 1 : -1];
+
+/* 等待提交的整套映射 */
+static uint8_t stage_map[REMAP_LAYERS][REMAP_KEYS];
+static uint8_t stage_fn[REMAP_LAYERS];
+static volatile bool stage_ready = false;
+
+static struct rt_mutex remap_lock;
+
+/* ================ 内部函数 ================ */
+
+/* 原始按键在某层的输出位，0表示无输出 */
+static uint16_t remap_bit(const uint8_t map[REMAP_LAYERS][REMAP_KEYS], uint8_t layer, uint8_t key)
+{
+    uint8_t dst = map[layer][key];
+
+    if (dst == REMAP_BASE)
+        dst = map[0][key];
+
+    return (dst < 16) ? (uint16_t)(1u << dst) : 0;
+}
+
+/* 按给定的各层映射编译一层到表t */
+static void remap_build(remap_table_t *t, const uint8_t map[REMAP_LAYERS][REMAP_KEYS], uint8_t layer)
+{
+    uint16_t bit_lo[8], bit_hi[8];
+
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        bit_lo[i] = remap_bit(map, layer, i);
+        bit_hi[i] = remap_bit(map, layer, i + 8);
+    }
+
+    /* 每个组合 = 去掉最低位后的组合 | 最低位的输出 */
+    t->lo[0] = 0;
+    t->hi[0] = 0;
+    for (uint32_t v = 1; v < 256; v++)
+    {
+        uint32_t low = (uint32_t)__builtin_ctz(v);
+
+        t->lo[v] = t->lo[v & (v - 1)] | bit_lo[low];
+        t->hi[v] = t->hi[v & (v - 1)] | bit_hi[low];
+    }
+}
+
+/* 编译一层并替换生效 */
+static void remap_compile(uint8_t layer)
+{
+    remap_table_t *t = spare_table;
+    rt_base_t level;
+
+    remap_build(t, (const uint8_t (*)[REMAP_KEYS])layer_map, layer);
+
+    level = rt_hw_interrupt_disable();
+    spare_table = (remap_table_t *)layer_table[layer];
+    layer_table[layer] = t;
+    rt_hw_interrupt_enable(level);
+}
+
+/* 基础层改变后其余层的REMAP_BASE项也要重新编译 */
+static void remap_compile_all(void)
+{
+    uint16_t mask = 0;
+
+    for (uint8_t l = 0; l < REMAP_LAYERS; l++)
+    {
+        remap_compile(l);
+        if (l > 0 && layer_fn[l] < REMAP_KEYS)
+            mask |= (uint16_t)(1u << layer_fn[l]);
+    }
+
+    fn_mask = mask;
+}
+
+/* ================ 公共API ================ */
+
+/* 把原始按键位图映射为报告按钮 */
+uint16_t remap_apply(uint16_t raw)
+{
+    const remap_table_t *t = layer_table[0];
+
+    for (uint8_t l = REMAP_LAYERS - 1; l > 0; l--)
+    {
+        if (layer_fn[l] < REMAP_KEYS && (raw & (1u << layer_fn[l])))
+        {
+            t = layer_table[l];
+            break;
+        }
+    }
+
+    raw &= ~fn_mask;
+    return t->lo[raw & 0xFF] | t->hi[raw >> 8];
+}
+
+/* 检查一层映射的表项 */
+static bool remap_check(uint8_t layer, const uint8_t map[REMAP_KEYS])
+{
+    for (uint8_t i = 0; i < REMAP_KEYS; i++)
+    {
+        if (map[i] >= 16 && map[i] != REMAP_NONE && !(map[i] == REMAP_BASE && layer > 0))
+            return false;
+    }
+
+    return true;
+}
+
+/* 设置一层的完整映射 */
+rt_err_t remap_set_layer(uint8_t layer, const uint8_t map[REMAP_KEYS])
+{
+    if (layer >= REMAP_LAYERS || !remap_check(layer, map))
+        return -RT_EINVAL;
+
+    rt_mutex_take(&remap_lock, RT_WAITING_FOREVER);
+    memcpy(layer_map[layer], map, REMAP_KEYS);
+    if (layer == 0)
+        remap_compile_all();
+    else
+        remap_compile(layer);
+    rt_mutex_release(&remap_lock);
+
+    return RT_EOK;
+}
+
+/* 读取一层的映射 */
+rt_err_t remap_get_layer(uint8_t layer, uint8_t map[REMAP_KEYS])
+{
+    if (layer >= REMAP_LAYERS)
+        return -RT_EINVAL;
+
+    memcpy(map, layer_map[layer], REMAP_KEYS);
+    return RT_EOK;
+}
+
+/* 设置一层的Fn键 */
+rt_err_t remap_set_fn(uint8_t layer, uint8_t key)
+{
+    if (layer == 0 || layer >= REMAP_LAYERS || (key >= REMAP_KEYS && key != REMAP_NONE))
+        return -RT_EINVAL;
+
+    rt_mutex_take(&remap_lock, RT_WAITING_FOREVER);
+    layer_fn[layer] = key;
+    remap_compile_all();
+    rt_mutex_release(&remap_lock);
+
+    return RT_EOK;
+}
+
+/* 读取一层的Fn键 */
+uint8_t remap_get_fn(uint8_t layer)
+{
+    return (layer > 0 && layer < REMAP_LAYERS) ? layer_fn[layer] : REMAP_NONE;
+}
+
+/* 在调用方线程预编译所有层 */
+rt_err_t remap_prepare(const uint8_t map[REMAP_LAYERS][REMAP_KEYS], const uint8_t fn[REMAP_LAYERS])
+{
+    for (uint8_t l = 0; l < REMAP_LAYERS; l++)
+    {
+        if (!remap_check(l, map[l]) || (l > 0 && fn[l] >= REMAP_KEYS && fn[l] != REMAP_NONE))
+            return -RT_EINVAL;
+    }
+
+    stage_ready = false;
+    memcpy(stage_map, map, sizeof(stage_map));
+    stage_fn[0] = REMAP_NONE;
+    for (uint8_t l = 1; l < REMAP_LAYERS; l++)
+        stage_fn[l] = fn[l];
+
+    /* 基础层的内容在编译时展开到各层的REMAP_BASE项 */
+    for (uint8_t l = 0; l < REMAP_LAYERS; l++)
+        remap_build(stage_table[l], (const uint8_t (*)[REMAP_KEYS])stage_map, l);
+    stage_ready = true;
+
+    return RT_EOK;
+}
+
+/* 提交预编译的映射 */
+rt_err_t remap_commit(void)
+{
+    uint16_t mask = 0;
+
+    if (!stage_ready)
+        return RT_EOK;
+
+    /* 命令线程正在修改映射时不等待 */
+    if (rt_mutex_take(&remap_lock, 0) != RT_EOK)
+        return -RT_EBUSY;
+
+    /* 在输入线程中调用，与remap_apply不会交错，逐层交换即可 */
+    for (uint8_t l = 0; l < REMAP_LAYERS; l++)
+    {
+        remap_table_t *t = stage_table[l];
+
+        stage_table[l] = (remap_table_t *)layer_table[l];
+        layer_table[l] = t;
+    }
+
+    memcpy(layer_map, stage_map, sizeof(layer_map));
+    for (uint8_t l = 1; l < REMAP_LAYERS; l++)
+    {
+        layer_fn[l] = stage_fn[l];
+        if (stage_fn[l] < REMAP_KEYS)
+            mask |= (uint16_t)(1u << stage_fn[l]);
+    }
+    fn_mask = mask;
+    stage_ready = false;
+
+    rt_mutex_release(&remap_lock);
+
+    return RT_EOK;
+}
+
+/* 恢复默认映射 */
+void remap_reset(void)
+{
+    rt_mutex_take(&remap_lock, RT_WAITING_FOREVER);
+
+    for (uint8_t i = 0; i < REMAP_KEYS; i++)
+        layer_map[0][i] = i;
+    for (uint8_t l = 1; l < REMAP_LAYERS; l++)
+    {
+        memset(layer_map[l], REMAP_BASE, REMAP_KEYS);
+        layer_fn[l] = REMAP_NONE;
+    }
+    remap_compile_all();
+
+    rt_mutex_release(&remap_lock);
+}
+
+static int remap_init(void)
+{
+    rt_mutex_init(&remap_lock, "remap", RT_IPC_FLAG_PRIO);
+
+    layer_fn[0] = REMAP_NONE;
+
+    remap_reset();
+    return 0;
+}
+INIT_ENV_EXPORT(remap_init);
+
+/* ================ 调试命令 ================ */
+
+/* 解析表项: 数字、none 或 base */
+static int remap_parse(const char *s, uint8_t *out)
+{
+    if (rt_strcmp(s, "none") == 0)
+        *out = REMAP_NONE;
+    else if (rt_strcmp(s, "base") == 0)
+        *out = REMAP_BASE;
+    else if (*s >= '0' && *s <= '9')
+        *out = (uint8_t)atoi(s);
+    else
+        return -1;
+
+    return 0;
+}
+
+static void remap_show(void)
+{
+    uint8_t map[REMAP_KEYS];
+
+    for (uint8_t l = 0; l < REMAP_LAYERS; l++)
+    {
+        remap_get_layer(l, map);
+        if (l == 0)
+            rt_kprintf("layer 0:      ");
+        else if (layer_fn[l] < REMAP_KEYS)
+            rt_kprintf("layer %d fn%2d: ", l, layer_fn[l]);
+        else
+            rt_kprintf("layer %d off : ", l);
+
+        for (uint8_t i = 0; i < REMAP_KEYS; i++)
+        {
+            if (map[i] == REMAP_NONE)
+                rt_kprintf("  -");
+            else if (map[i] == REMAP_BASE)
+                rt_kprintf("  .");
+            else
+                rt_kprintf(" %2d", map[i]);
+        }
+        rt_kprintf("\n");
+    }
+}
+
+static int remap(int argc, char **argv)
+{
+    uint8_t layer, key, dst;
+    uint8_t map[REMAP_KEYS];
+
+    if (argc < 2)
+    {
+        remap_show();
+        return 0;
+    }
+
+    if (rt_strcmp(argv[1], "reset") == 0)
+    {
+        remap_reset();
+    }
+    else if (rt_strcmp(argv[1], "fn") == 0 && argc == 4)
+    {
+        layer = (uint8_t)atoi(argv[2]);
+        if (remap_parse(argv[3], &key) != 0 || remap_set_fn(layer, key) != RT_EOK)
+        {
+            rt_kprintf("invalid fn setting\n");
+            return -1;
+        }
+    }
+    else if (argc == 4)
+    {
+        layer = (uint8_t)atoi(argv[1]);
+        key = (uint8_t)atoi(argv[2]);
+        if (remap_get_layer(layer, map) != RT_EOK || key >= REMAP_KEYS ||
+            remap_parse(argv[3], &dst) != 0)
+        {
+            rt_kprintf("invalid mapping\n");
+            return -1;
+        }
+
+        map[key] = dst;
+        if (remap_set_layer(layer, map) != RT_EOK)
+        {
+            rt_kprintf("invalid mapping\n");
+            return -1;
+        }
+    }
+    else
+    {
+        rt_kprintf("usage: remap [reset | fn <layer> <key|none> | <layer> <key> <button|none|base>]\n");
+        return -1;
+    }
+
+    remap_show();
+    return 0;
+}
+MSH_CMD_EXPORT(remap, button remap: remap [reset | fn <layer> <key|none> | <layer> <key> <button|none|base>]);
@@ -0,0 +1,93 @@
+/**
+ * @file remap.h
+ * @brief 按键重映射引擎
+ * @details 16位原始按键位图(矩阵bit0-13，摇杆按键bit14/15)经当前层映射为报告按钮位。
+ *          每层映射在修改时编译成高低字节两张256项查找表，
+ *          运行时只需两次查表和一次或运算，与映射内容无关。
+ *          切换配置时先在调用方线程预编译(remap_prepare)，输入线程只交换指针(remap_commit)
+ */
+
+#ifndef __REMAP_H__
+#define __REMAP_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ================ 配置参数 ================ */
+
+#define REMAP_KEYS          16      /* 原始按键数 */
+#define REMAP_LAYERS        4       /* 层数，层0为基础层 */
+
+/* 映射表项特殊值 */
+#define REMAP_NONE          0xFF    /* 禁用该按键 */
+#define REMAP_BASE          0xFE    /* 沿用基础层映射(层1以上有效) */
+
+/**
+ * @brief 把原始按键位图映射为报告按钮
+ * @param raw 原始按键位图
+ * @return 报告按钮位图
+ * @note 按住某层的Fn键时使用该层(多个同时按下时取层号最大者)，Fn键本身不输出
+ */
+uint16_t remap_apply(uint16_t raw);
+
+/**
+ * @brief 设置一层的完整映射并重新编译
+ * @param layer 层号
+ * @param map 每个原始按键对应的按钮位0-15，或REMAP_NONE/REMAP_BASE
+ * @return RT_EOK成功，-RT_EINVAL参数错误
+ */
+rt_err_t remap_set_layer(uint8_t layer, const uint8_t map[REMAP_KEYS]);
+
+/**
+ * @brief 读取一层的映射
+ * @param layer 层号
+ * @param map 输出映射
+ * @return RT_EOK成功
+ */
+rt_err_t remap_get_layer(uint8_t layer, uint8_t map[REMAP_KEYS]);
+
+/**
+ * @brief 设置一层的Fn键
+ * @param layer 层号(1 ~ REMAP_LAYERS-1)
+ * @param key 原始按键号，REMAP_NONE表示停用该层
+ * @return RT_EOK成功，-RT_EINVAL参数错误
+ */
+rt_err_t remap_set_fn(uint8_t layer, uint8_t key);
+
+/**
+ * @brief 读取一层的Fn键
+ * @param layer 层号(1 ~ REMAP_LAYERS-1)
+ * @return 原始按键号，REMAP_NONE表示该层未启用
+ */
+uint8_t remap_get_fn(uint8_t layer);
+
+/**
+ * @brief 在调用方线程把所有层的映射和Fn键预先编译到备用表，当前映射不变
+ * @param map 各层映射，含义同remap_set_layer
+ * @param fn 各层Fn键，fn[0]忽略
+ * @return RT_EOK成功，-RT_EINVAL参数错误(不做任何修改)
+ * @note 用于整体切换配置，由remap_commit生效；调用方保证不与remap_commit同时执行，
+ *       提交前再次调用时以最后一次为准
+ */
+rt_err_t remap_prepare(const uint8_t map[REMAP_LAYERS][REMAP_KEYS], const uint8_t fn[REMAP_LAYERS]);
+
+/**
+ * @brief 在输入线程中让预编译的映射生效，只交换表指针，不编译也不等待
+ * @return RT_EOK成功或没有待提交的映射，-RT_EBUSY映射正在被修改，调用方下个周期重试
+ */
+rt_err_t remap_commit(void);
+
+/**
+ * @brief 恢复默认映射: 基础层一一对应，其余层沿用基础层且无Fn键
+ */
+void remap_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REMAP_H__ */
@@ -0,0 +1,272 @@
+/**
+ * @file stick_shape.c
+ * @brief 摇杆输出整形实现
+ * @details 径向死区保持摇杆方向不变(斜向不会吸附到坐标轴)，
+ *          响应曲线在加载配置时预先算成表，采样时只做查表和线性插值。
+ *          每个摇杆有两份状态，切换配置时新表在调用方线程生成到另一份中，输入线程只交换指针
+ */
+
+#include "stick_shape.h"
+#include "int_math.h"
+#include <stdlib.h>
+
+/* ================ 内部定义 ================ */
+
+#define STICK_AXIS_MAX      32767
+#define STICK_T_BITS        15                              /* 归一化行程 t 为Q15 */
+#define STICK_FRAC_BITS     (STICK_T_BITS - STICK_SHAPE_LUT_BITS)
+#define STICK_FRAC_MASK     ((1 << STICK_FRAC_BITS) - 1)
+
+/* 每个摇杆的整形状态 */
+typedef struct {
+    stick_shape_config_t cfg;
+    int32_t inner;                          /* 内死区半径 */
+    int32_t outer;                          /* 外死区半径 */
+    uint32_t span_inv;                      /* 65536 * 32768 / (outer - inner) */
+    uint16_t lut[STICK_SHAPE_LUT_SIZE];     /* 归一化行程(Q15) -> 输出半径 */
+} stick_shape_t;
+
+static const char *const curve_names[STICK_CURVE_NUM] = {"linear", "expo", "scurve"};
+
+/* ================ 内部变量 ================ */
+
+static stick_shape_t shape_buf[STICK_NUM][2];
+static stick_shape_t *volatile shapes[STICK_NUM] = {&shape_buf[STICK_LEFT][0], &shape_buf[STICK_RIGHT][0]};
+static stick_shape_t *stage[STICK_NUM] = {&shape_buf[STICK_LEFT][1], &shape_buf[STICK_RIGHT][1]};
+static volatile bool stage_ready[STICK_NUM];
+
+/* ================ 内部函数 ================ */
+
+/* 响应曲线 f(t)，t和返回值均为Q15 */
+static int32_t curve_eval(const stick_shape_config_t *cfg, int32_t t)
+{
+    int32_t k = (int32_t)cfg->strength * 32768 / 100;
+    int32_t t2 = (t * t) >> 15;
+    int32_t t3 = (t2 * t) >> 15;
+    int32_t shaped;
+
+    switch (cfg->curve)
+    {
+    case STICK_CURVE_EXPO:
+        shaped = t3;                        /* t^3 */
+        break;
+    case STICK_CURVE_SCURVE:
+        shaped = 3 * t2 - 2 * t3;           /* smoothstep: 3t^2 - 2t^3 */
+        break;
+    default:
+        return t;
+    }
+
+    /* 按强度在线性和曲线之间混合 */
+    return (int32_t)(((int64_t)(32768 - k) * t + (int64_t)k * shaped) >> 15);
+}
+
+/* 检查配置范围 */
+static bool shape_check(stick_id_t stick, const stick_shape_config_t *cfg)
+{
+    return stick < STICK_NUM && cfg != RT_NULL &&
+           cfg->curve < STICK_CURVE_NUM && cfg->strength <= 100 &&
+           cfg->outer <= STICK_AXIS_MAX && cfg->inner < cfg->outer &&
+           cfg->anti <= STICK_AXIS_MAX;
+}
+
+/* 由配置生成整形状态和曲线表 */
+static void shape_build(stick_shape_t *shape, const stick_shape_config_t *cfg)
+{
+    int32_t anti = cfg->anti, f, out;
+
+    for (uint32_t i = 0; i < STICK_SHAPE_LUT_SIZE; i++)
+    {
+        int32_t t = (int32_t)(i << STICK_FRAC_BITS);
+
+        if (t > 32767)
+            t = 32767;
+
+        /* 离开内死区即从反死区值起步 */
+        f = curve_eval(cfg, t);
+        out = anti + (((STICK_AXIS_MAX - anti) * f) >> 15);
+        if (out > STICK_AXIS_MAX)
+            out = STICK_AXIS_MAX;
+        shape->lut[i] = (uint16_t)out;
+    }
+    shape->lut[STICK_SHAPE_LUT_SIZE - 1] = STICK_AXIS_MAX;
+
+    shape->inner = cfg->inner;
+    shape->outer = cfg->outer;
+    shape->span_inv = (uint32_t)((32768ULL << 16) / (uint32_t)(cfg->outer - cfg->inner));
+    shape->cfg = *cfg;
+}
+
+/* ================ 公共API ================ */
+
+/* 加载整形配置并生成曲线表 */
+rt_err_t stick_shape_load(stick_id_t stick, const stick_shape_config_t *cfg)
+{
+    if (!shape_check(stick, cfg))
+        return -RT_EINVAL;
+
+    shape_build(shapes[stick], cfg);
+    return RT_EOK;
+}
+
+/* 在调用方线程生成待切换的曲线表 */
+rt_err_t stick_shape_prepare(stick_id_t stick, const stick_shape_config_t *cfg)
+{
+    if (!shape_check(stick, cfg))
+        return -RT_EINVAL;
+
+    stage_ready[stick] = false;
+    shape_build(stage[stick], cfg);
+    stage_ready[stick] = true;
+
+    return RT_EOK;
+}
+
+/* 让预先生成的曲线表生效 */
+void stick_shape_commit(void)
+{
+    for (uint32_t i = 0; i < STICK_NUM; i++)
+    {
+        stick_shape_t *shape;
+
+        if (!stage_ready[i])
+            continue;
+
+        shape = stage[i];
+        stage[i] = shapes[i];
+        shapes[i] = shape;
+        stage_ready[i] = false;
+    }
+}
+
+/* 获取当前整形配置 */
+const stick_shape_config_t *stick_shape_get(stick_id_t stick)
+{
+    return &shapes[stick]->cfg;
+}
+
+/* 对一个摇杆的X/Y应用径向死区和响应曲线 */
+void stick_shape_apply(stick_id_t stick, joystick_data_t *data)
+{
+    const stick_shape_t *shape = shapes[stick];
+    int32_t x = data->x;
+    int32_t y = data->y;
+    int32_t r, s, t, idx;
+
+    r = (int32_t)isqrt32((uint32_t)(x * x) + (uint32_t)(y * y));
+
+    if (r <= shape->inner)
+    {
+        data->x = 0;
+        data->y = 0;
+        return;
+    }
+
+    if (r >= shape->outer)
+    {
+        s = shape->lut[STICK_SHAPE_LUT_SIZE - 1];
+    }
+    else
+    {
+        /* 归一化行程 -> 查表 + 线性插值 */
+        t = (int32_t)(((uint64_t)(uint32_t)(r - shape->inner) * shape->span_inv) >> 16);
+        idx = t >> STICK_FRAC_BITS;
+        s = shape->lut[idx] +
+            (((shape->lut[idx + 1] - shape->lut[idx]) * (t & STICK_FRAC_MASK)) >> STICK_FRAC_BITS);
+    }
+
+    /* 沿原方向缩放到新半径 */
+    x = x * s / r;
+    y = y * s / r;
+
+    if (x > STICK_AXIS_MAX) x = STICK_AXIS_MAX;
+    if (x < -STICK_AXIS_MAX) x = -STICK_AXIS_MAX;
+    if (y > STICK_AXIS_MAX) y = STICK_AXIS_MAX;
+    if (y < -STICK_AXIS_MAX) y = -STICK_AXIS_MAX;
+
+    data->x = (int16_t)x;
+    data->y = (int16_t)y;
+}
+
+/* 以默认配置初始化两个摇杆 */
+static int stick_shape_init(void)
+{
+    stick_shape_config_t cfg = {
+        .curve = STICK_CURVE_LINEAR,
+        .strength = 0,
+        .inner = STICK_SHAPE_INNER_DEFAULT,
+        .outer = STICK_SHAPE_OUTER_DEFAULT,
+        .anti = 0,
+    };
+
+    stick_shape_load(STICK_LEFT, &cfg);
+    stick_shape_load(STICK_RIGHT, &cfg);
+
+    return 0;
+}
+INIT_ENV_EXPORT(stick_shape_init);
+
+/* ================ 调试命令 ================ */
+
+/* 查看/设置摇杆整形参数 */
+static int stick_shape(int argc, char **argv)
+{
+    static const char *const stick_names[STICK_NUM] = {"left", "right"};
+    stick_shape_config_t cfg;
+    stick_id_t stick;
+    uint32_t i;
+
+    if (argc < 2)
+    {
+        for (i = 0; i < STICK_NUM; i++)
+        {
+            cfg = shapes[i]->cfg;
+            rt_kprintf("%s: %s strength %d%%, inner %d, outer %d, anti %d\n",
+                       stick_names[i], curve_names[cfg.curve], cfg.strength,
+                       cfg.inner, cfg.outer, cfg.anti);
+        }
+        rt_kprintf("usage: stick_shape <l|r> <linear|expo|scurve> [strength] [inner] [outer] [anti]\n");
+        return 0;
+    }
+
+    if (argc < 3)
+    {
+        rt_kprintf("usage: stick_shape <l|r> <linear|expo|scurve> [strength] [inner] [outer] [anti]\n");
+        return -1;
+    }
+
+    stick = (argv[1][0] == 'r') ? STICK_RIGHT : STICK_LEFT;
+    cfg = shapes[stick]->cfg;
+
+    for (i = 0; i < STICK_CURVE_NUM; i++)
+    {
+        if (rt_strcmp(argv[2], curve_names[i]) == 0)
+            break;
+    }
+    if (i == STICK_CURVE_NUM)
+    {
+        rt_kprintf("unknown curve: %s\n", argv[2]);
+        return -1;
+    }
+    cfg.curve = (uint8_t)i;
+
+    if (argc > 3) cfg.strength = (uint8_t)atoi(argv[3]);
+    if (argc > 4) cfg.inner = (uint16_t)atoi(argv[4]);
+    if (argc > 5) cfg.outer = (uint16_t)atoi(argv[5]);
+    if (argc > 6) cfg.anti = (uint16_t)atoi(argv[6]);
+
+    if (stick_shape_load(stick, &cfg) != RT_EOK)
+    {
+        rt_kprintf("invalid parameters\n");
+        return -1;
+    }
+
+    rt_kprintf("%s stick curve table:\n", stick_names[stick]);
+    for (i = 0; i < STICK_SHAPE_LUT_SIZE; i += 8)
+    {
+        rt_kprintf("  t=%3d%% -> %d\n", (int)(i * 100 / (STICK_SHAPE_LUT_SIZE - 1)), shapes[stick]->lut[i]);
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(stick_shape, show or set stick deadzone and response curve);
@@ -0,0 +1,92 @@
+/**
+ * @file stick_shape.h
+ * @brief 摇杆输出整形: 径向内外死区 + 查表响应曲线
+ * @details 曲线表在加载配置时生成，每次采样只需一次开方、一次查表插值和缩放；
+ *          切换配置时表在调用方线程预先生成，输入线程只交换指针
+ */
+
+#ifndef __STICK_SHAPE_H__
+#define __STICK_SHAPE_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+#include "joystick_app.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ================ 配置参数 ================ */
+
+#define STICK_SHAPE_LUT_BITS     6                              /* 曲线表分段数 2^6 */
+#define STICK_SHAPE_LUT_SIZE     ((1 << STICK_SHAPE_LUT_BITS) + 1)
+
+#define STICK_SHAPE_INNER_DEFAULT  600      /* 默认内死区半径 (摇杆数据已过采样) */
+#define STICK_SHAPE_OUTER_DEFAULT  32767    /* 默认外死区半径，超出即满量程 */
+
+/* 摇杆编号 */
+typedef enum {
+    STICK_LEFT = 0,
+    STICK_RIGHT,
+    STICK_NUM
+} stick_id_t;
+
+/* 响应曲线类型 */
+typedef enum {
+    STICK_CURVE_LINEAR = 0,     /* 线性 */
+    STICK_CURVE_EXPO,           /* 指数: 中心细腻，边缘加速 */
+    STICK_CURVE_SCURVE,         /* S曲线: 中心和边缘平缓，中段加速 */
+    STICK_CURVE_NUM
+} stick_curve_t;
+
+/* 整形配置 */
+typedef struct {
+    uint8_t curve;          /* stick_curve_t */
+    uint8_t strength;       /* 曲线强度 0~100 (%)，线性曲线忽略 */
+    uint16_t inner;         /* 内死区半径 (0~32767) */
+    uint16_t outer;         /* 外死区半径，大于inner */
+    uint16_t anti;          /* 反死区: 离开内死区后的最小输出 (0~32767)，抵消游戏自身死区 */
+} stick_shape_config_t;
+
+/**
+ * @brief 加载整形配置并生成曲线表
+ * @param stick 摇杆编号
+ * @param cfg 整形配置
+ * @return RT_EOK成功，-RT_EINVAL参数错误
+ * @note 不在采样热路径中调用；表切换期间的单次采样可能混用新旧参数
+ */
+rt_err_t stick_shape_load(stick_id_t stick, const stick_shape_config_t *cfg);
+
+/**
+ * @brief 在调用方线程生成待切换的曲线表，当前整形不变
+ * @param stick 摇杆编号
+ * @param cfg 整形配置
+ * @return RT_EOK成功，-RT_EINVAL参数错误
+ * @note 由stick_shape_commit生效；调用方保证不与stick_shape_commit同时执行
+ */
+rt_err_t stick_shape_prepare(stick_id_t stick, const stick_shape_config_t *cfg);
+
+/**
+ * @brief 在输入线程中让stick_shape_prepare生成的表生效，只交换指针
+ */
+void stick_shape_commit(void);
+
+/**
+ * @brief 获取当前整形配置
+ * @param stick 摇杆编号
+ * @return 配置指针
+ */
+const stick_shape_config_t *stick_shape_get(stick_id_t stick);
+
+/**
+ * @brief 对一个摇杆的X/Y应用径向死区和响应曲线
+ * @param stick 摇杆编号
+ * @param data 摇杆数据，x/y原地更新，方向保持不变
+ */
+void stick_shape_apply(stick_id_t stick, joystick_data_t *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STICK_SHAPE_H__ */
@@ -0,0 +1,71 @@
+/**
+ * @file timestamp.c
+ * @brief 基于DWT周期计数器的高精度时间戳
+ * @details DWT->CYCCNT只有32位，在96MHz下约44s回绕，这里扩展为64位后换算成微秒。
+ *          扩展依赖于至少每次回绕调用一次，由一个软件定时器保证
+ */
+
+#include "timestamp.h"
+#include <rthw.h>
+
+#define TS_KEEPALIVE_MS  10000   /* 保活间隔，须小于计数器回绕周期 */
+
+static rt_uint32_t ts_last = 0;       /* 上一次读到的CYCCNT */
+static rt_uint32_t ts_high = 0;       /* 64位周期计数的高32位 */
+static rt_uint32_t ts_cycles_per_us = 1;
+static struct rt_timer ts_keepalive;
+
+/* 读取64位周期计数 */
+static rt_uint64_t ts_cycles64(void)
+{
+    rt_base_t level;
+    rt_uint32_t now;
+    rt_uint64_t cycles;
+
+    level = rt_hw_interrupt_disable();
+    now = DWT->CYCCNT;
+    if (now < ts_last)
+        ts_high++;
+    ts_last = now;
+    cycles = ((rt_uint64_t)ts_high << 32) | now;
+    rt_hw_interrupt_enable(level);
+
+    return cycles;
+}
+
+static void ts_keepalive_entry(void *parameter)
+{
+    (void)parameter;
+    ts_cycles64();
+}
+
+/* 使能DWT周期计数器 */
+static int ts_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    ts_cycles_per_us = SystemCoreClock / 1000000;
+    if (ts_cycles_per_us == 0)
+        ts_cycles_per_us = 1;
+
+    rt_timer_init(&ts_keepalive, "ts", ts_keepalive_entry, RT_NULL,
+                  rt_tick_from_millisecond(TS_KEEPALIVE_MS), RT_TIMER_FLAG_PERIODIC);
+    rt_timer_start(&ts_keepalive);
+
+    return 0;
+}
+INIT_PREV_EXPORT(ts_init);
+
+/* 获取微秒时间戳 */
+rt_uint32_t ts_us(void)
+{
+    return (rt_uint32_t)(ts_cycles64() / ts_cycles_per_us);
+}
+
+/* 将CPU周期数换算为微秒 */
+rt_uint32_t ts_cycles_to_us(rt_uint32_t cycles)
+{
+    return cycles / ts_cycles_per_us;
+}
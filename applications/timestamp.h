@@ -0,0 +1,43 @@
+/**
+ * @file timestamp.h
+ * @brief 基于DWT周期计数器的高精度时间戳
+ */
+
+#ifndef __TIMESTAMP_H__
+#define __TIMESTAMP_H__
+
+#include <rtthread.h>
+#include <board.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 读取32位CPU周期计数(约44s回绕一次，适合测量短间隔)
+ * @return 当前DWT->CYCCNT
+ */
+rt_inline rt_uint32_t ts_cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief 获取微秒时间戳
+ * @return 自启动以来的微秒数(32位，约71分钟回绕)
+ * @note 可在中断中调用
+ */
+rt_uint32_t ts_us(void);
+
+/**
+ * @brief 将CPU周期数换算为微秒
+ * @param cycles 周期数
+ * @return 微秒数
+ */
+rt_uint32_t ts_cycles_to_us(rt_uint32_t cycles);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TIMESTAMP_H__ */
@@ -5,6 +5,9 @@
  */
 
 #include "usb_app.h"
+#include "timestamp.h"
+#include "latency.h"
+#include <rthw.h>
 #include <string.h>
 
 /* ================ USB描述符定义 ================ */
@@ -200,14 +203,71 @@ static const uint8_t hid_gamepad_report_desc[HID_GAMEPAD_REPORT_DESC_SIZE] = {
 #define HID_STATE_BUSY 1
 static volatile uint8_t hid_state = HID_STATE_IDLE;
 
-/* 游戏手柄报告数据缓冲区 */
-USB_NOCACHE_RAM_SECTION USB_MEM_ALIGNX usb_gamepad_report_t gamepad_report;
+/*
+ * 报告缓冲区: 三个槽位分别用于正在发送、已发布待发送和正在生成。
+ * 生成方只写生成槽，发布时与待发送槽交换；端点空闲时立即发送，
+ * 否则由发送完成中断取最新发布的报告继续发送，未发出的旧报告直接被覆盖
+ */
+#define HID_SLOT_NUM   3
+#define HID_SLOT_NONE  0xFF
+
+#if LATENCY_SLOTS != HID_SLOT_NUM
+#error "LATENCY_SLOTS must match HID_SLOT_NUM"
+#endif
+
+/* 每个槽位按USB对齐单位补齐，保证三个发送缓冲区的起始地址都满足对齐要求 */
+typedef union {
+    usb_gamepad_report_t report;
+    uint8_t raw[USB_ALIGN_UP(sizeof(usb_gamepad_report_t), CONFIG_USB_ALIGN_SIZE)];
+} hid_report_slot_t;
+
+USB_NOCACHE_RAM_SECTION USB_MEM_ALIGNX hid_report_slot_t gamepad_report[HID_SLOT_NUM];
+
+static volatile uint8_t slot_send = HID_SLOT_NONE;     /* 正在发送 */
+static volatile uint8_t slot_pending = HID_SLOT_NONE;  /* 已发布待发送 */
+static uint8_t slot_build = 0;                         /* 正在生成 */
 
 /* USB接口对象 */
 static struct usbd_interface intf0;
 
+/* 报告数据年龄: 采样时刻到IN传输完成 */
+static uint32_t slot_sample_us[HID_SLOT_NUM];          /* 各槽位报告的采样时刻 */
+static usb_report_age_t report_age = {0, 0, UINT32_MAX, 0};
+
 /* ================ 内部函数实现 ================ */
 
+/* 复位报告通道，丢弃正在发送和待发送的报告 */
+static void hid_slots_reset(void)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+
+    hid_state = HID_STATE_IDLE;
+    slot_send = HID_SLOT_NONE;
+    slot_pending = HID_SLOT_NONE;
+
+    rt_hw_interrupt_enable(level);
+}
+
+/* 发送待发送槽，需在关中断或中断上下文中调用 */
+static int hid_slot_arm(uint8_t busid)
+{
+    uint8_t slot = slot_pending;
+
+    if (slot == HID_SLOT_NONE || hid_state == HID_STATE_BUSY)
+        return 0;
+
+    LATENCY_SLOT_MARK(slot, LATENCY_ARMED);
+    if (usbd_ep_start_write(busid, HID_INT_EP, (uint8_t *)&gamepad_report[slot].report,
+                            sizeof(usb_gamepad_report_t)) < 0)
+        return -3;  /* 保留待发送槽，下次发布或发送完成时重试 */
+
+    hid_state = HID_STATE_BUSY;
+    slot_send = slot;
+    slot_pending = HID_SLOT_NONE;
+
+    return 0;
+}
+
 /**
  * @brief USB设备事件处理回调函数
  */
@@ -224,7 +284,7 @@ static void usbd_event_handler(uint8_t busid, uint8_t event)
 
         case USBD_EVENT_DISCONNECTED:
             rt_kprintf("[USB] Device Disconnected\n");
-            hid_state = HID_STATE_IDLE;
+            hid_slots_reset();
             break;
 
         case USBD_EVENT_RESUME:
@@ -237,7 +297,7 @@ static void usbd_event_handler(uint8_t busid, uint8_t event)
 
         case USBD_EVENT_CONFIGURED:
             rt_kprintf("[USB] Device Configured - Gamepad Ready!\n");
-            hid_state = HID_STATE_IDLE;
+            hid_slots_reset();
             break;
 
         case USBD_EVENT_SET_REMOTE_WAKEUP:
@@ -254,12 +314,25 @@ static void usbd_event_handler(uint8_t busid, uint8_t event)
 /* HID中断端点发送完成回调函数 */
 void usbd_hid_int_callback(uint8_t busid, uint8_t ep, uint32_t nbytes)
 {
-    (void)busid;
+    uint32_t age;
+
     (void)ep;
     (void)nbytes;
 
-    /* 数据发送完成，恢复空闲状态 */
+    if (slot_send != HID_SLOT_NONE)
+    {
+        age = ts_us() - slot_sample_us[slot_send];
+        report_age.count++;
+        report_age.sum_us += age;
+        if (age < report_age.min_us) report_age.min_us = age;
+        if (age > report_age.max_us) report_age.max_us = age;
+        LATENCY_DONE_SLOT(slot_send);
+    }
+
+    /* 数据发送完成，有新发布的报告则立即续发 */
     hid_state = HID_STATE_IDLE;
+    slot_send = HID_SLOT_NONE;
+    hid_slot_arm(busid);
 }
 
 /* HID IN端点定义 */
@@ -286,55 +359,83 @@ void hid_gamepad_init(uint8_t busid, uintptr_t reg_base)
     /* 添加HID中断IN端点 */
     usbd_add_endpoint(busid, &hid_in_ep);
 
+    /* 初始化游戏手柄报告数据为中立状态 */
+    memset(gamepad_report, 0, sizeof(gamepad_report));
+    for (int i = 0; i < HID_SLOT_NUM; i++) {
+        gamepad_report[i].report.hat = GAMEPAD_HAT_CENTER;  /* 方向键居中 */
+    }
+
     /* 初始化USB设备 */
     usbd_initialize(busid, reg_base, usbd_event_handler);
 
-    /* 初始化游戏手柄报告数据为中立状态 */
-    memset(&gamepad_report, 0, sizeof(gamepad_report));
-    gamepad_report.hat = GAMEPAD_HAT_CENTER;  /* 方向键居中 */
-
     rt_kprintf("[USB] HID Gamepad initialized successfully\n");
     rt_kprintf("[USB] VID:0x%04X PID:0x%04X\n", USBD_VID, USBD_PID);
 }
 
-/* 发送游戏手柄报告数据 */
+/* 发布游戏手柄报告数据 */
 int hid_gamepad_send_report(uint8_t busid, const usb_gamepad_report_t *report)
 {
+    rt_base_t level;
+    uint8_t published = slot_build;
+    uint8_t slot;
+    int ret;
+
     /* 检查设备是否已配置 */
     if (!usb_device_is_configured(busid)) {
         return -1;  /* 设备未配置 */
     }
 
-    /* 检查HID是否忙碌 */
-    if (hid_state == HID_STATE_BUSY) {
-        return -2;  /* 设备忙碌 */
+    /* 复制报告数据到生成槽 */
+    if (report != NULL && report != &gamepad_report[slot_build].report) {
+        memcpy(&gamepad_report[slot_build].report, report, sizeof(usb_gamepad_report_t));
     }
 
-    /* 复制报告数据到缓冲区 */
-    if (report != NULL && report != &gamepad_report) {
-        memcpy(&gamepad_report, report, sizeof(usb_gamepad_report_t));
-    }
+    level = rt_hw_interrupt_disable();
 
-    /* 设置忙碌状态 */
-    hid_state = HID_STATE_BUSY;
+    /* 生成槽成为待发送槽，尚未发出的旧报告被覆盖；剩下的空闲槽作为新的生成槽 */
+    slot_pending = published;
+    LATENCY_PUBLISH(published);
+    for (slot = 0; slot == slot_send || slot == slot_pending; slot++)
+        ;
+    slot_build = slot;
+    ret = hid_slot_arm(busid);
 
-    /* 通过中断端点发送数据 */
-    int ret = usbd_ep_start_write(busid, HID_INT_EP,
-                                   (uint8_t *)&gamepad_report,
-                                   sizeof(usb_gamepad_report_t));
+    rt_hw_interrupt_enable(level);
 
-    if (ret < 0) {
-        hid_state = HID_STATE_IDLE;
-        return -3;  /* 发送失败 */
-    }
+    /* 新生成槽从最新报告开始，调用方可只修改变化的字段 */
+    gamepad_report[slot_build].report = gamepad_report[published].report;
+    slot_sample_us[slot_build] = slot_sample_us[published];
 
-    return 0;  /* 成功 */
+    return ret;
 }
 
-/* 获取游戏手柄报告缓冲区 */
+/* 获取报告生成缓冲区 */
 usb_gamepad_report_t* hid_gamepad_get_report(void)
 {
-    return &gamepad_report;
+    return &gamepad_report[slot_build].report;
+}
+
+/* 设置下一份报告的采样时刻 */
+void hid_gamepad_set_sample_time(uint32_t sample_us)
+{
+    slot_sample_us[slot_build] = sample_us;
+}
+
+/* 获取报告数据年龄统计 */
+void hid_gamepad_get_age(usb_report_age_t *age, bool reset)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+
+    *age = report_age;
+    if (reset)
+    {
+        report_age.count = 0;
+        report_age.sum_us = 0;
+        report_age.min_us = UINT32_MAX;
+        report_age.max_us = 0;
+    }
+
+    rt_hw_interrupt_enable(level);
 }
 
 /* 检查USB设备是否已配置 */
@@ -346,6 +447,8 @@ bool hid_gamepad_is_configured(uint8_t busid)
 /* 测试函数 - 模拟摇杆旋转和按钮按下 */
 void hid_gamepad_test(uint8_t busid)
 {
+    usb_gamepad_report_t *report;
+
     if (!usb_device_is_configured(busid)) {
         rt_kprintf("[USB] Device not configured, waiting...\n");
         return;
@@ -357,32 +460,29 @@ void hid_gamepad_test(uint8_t busid)
     #define TEST_STEPS  100
 
     for (int i = 0; i < TEST_STEPS; i++) {
+        report = hid_gamepad_get_report();
+
         /* 模拟左摇杆运动 */
-        gamepad_report.left_x = (int8_t)((i * 127) / TEST_STEPS);
-        gamepad_report.left_y = (int8_t)((i * 127) / TEST_STEPS);
+        report->left_x = (int8_t)((i * 127) / TEST_STEPS);
+        report->left_y = (int8_t)((i * 127) / TEST_STEPS);
 
         /* 右摇杆反向运动 */
-        gamepad_report.right_x = -gamepad_report.left_x;
-        gamepad_report.right_y = -gamepad_report.left_y;
+        report->right_x = -report->left_x;
+        report->right_y = -report->left_y;
 
         /* 模拟扳机按压(周期性变化) */
-        gamepad_report.left_trigger = (uint8_t)((i * 255) / TEST_STEPS);
-        gamepad_report.right_trigger = (uint8_t)(255 - ((i * 255) / TEST_STEPS));
+        report->left_trigger = (uint8_t)((i * 255) / TEST_STEPS);
+        report->right_trigger = (uint8_t)(255 - ((i * 255) / TEST_STEPS));
 
         /* 循环按下不同按钮 */
-        gamepad_report.buttons = (uint16_t)(1 << (i % 16));
+        report->buttons = (uint16_t)(1 << (i % 16));
 
         /* 循环切换方向键 */
-        gamepad_report.hat = i % 9;
+        report->hat = i % 9;
 
-        /* 发送报告 */
+        /* 发布报告 */
         hid_gamepad_send_report(busid, NULL);
 
-        /* 等待发送完成 */
-        while (hid_state == HID_STATE_BUSY) {
-            rt_thread_mdelay(1);
-        }
-
         /* 控制测试速度 */
         rt_thread_mdelay(50);
 
@@ -393,8 +493,9 @@ void hid_gamepad_test(uint8_t busid)
     }
 
     /* 测试完成，复位为中立状态 */
-    memset(&gamepad_report, 0, sizeof(gamepad_report));
-    gamepad_report.hat = GAMEPAD_HAT_CENTER;
+    report = hid_gamepad_get_report();
+    memset(report, 0, sizeof(*report));
+    report->hat = GAMEPAD_HAT_CENTER;
     hid_gamepad_send_report(busid, NULL);
 
     rt_kprintf("[USB] Gamepad test completed!\n");
@@ -50,6 +50,16 @@ typedef struct __attribute__((packed)) {
     uint8_t hat;           /* 方向键/Hat Switch (0-8, 8=center) */
 } usb_gamepad_report_t;
 
+/**
+ * @brief 报告数据年龄统计 (采样到IN传输完成)
+ */
+typedef struct {
+    uint32_t count;        /* 完成的传输数 */
+    uint64_t sum_us;       /* 年龄累计 */
+    uint32_t min_us;
+    uint32_t max_us;
+} usb_report_age_t;
+
 /* ================ 按钮位定义 ================ */
 
 #define GAMEPAD_BUTTON_A      (1 << 0)   /* A按钮 */
@@ -92,19 +102,35 @@ typedef struct __attribute__((packed)) {
 void hid_gamepad_init(uint8_t busid, uintptr_t reg_base);
 
 /**
- * @brief 发送游戏手柄报告数据
+ * @brief 发布游戏手柄报告数据
  * @param busid USB总线ID
- * @param report 游戏手柄报告数据指针 (NULL则使用内部缓冲区)
- * @return 0表示成功，-1表示设备未配置，-2表示设备忙，-3表示发送失败
+ * @param report 游戏手柄报告数据指针 (NULL则发布hid_gamepad_get_report()返回的生成缓冲区)
+ * @return 0表示成功，-1表示设备未配置，-3表示启动发送失败(报告保留，下次发布时重试)
+ * @note 端点忙时报告作为最新状态等待发送，上一次发布但尚未发出的报告被覆盖，
+ *       发送完成中断会立即续发最新报告，调用方无需重试
  */
 int hid_gamepad_send_report(uint8_t busid, const usb_gamepad_report_t *report);
 
 /**
- * @brief 获取游戏手柄报告缓冲区（可直接修改）
- * @return 游戏手柄报告数据指针
+ * @brief 获取报告生成缓冲区（可直接修改）
+ * @return 游戏手柄报告数据指针，内容为最近一次发布的报告；
+ *         该缓冲区不会被USB传输使用，发布后指针失效，需重新获取
  */
 usb_gamepad_report_t* hid_gamepad_get_report(void);
 
+/**
+ * @brief 设置下一份报告的输入采样时刻
+ * @param sample_us 采样时的ts_us()，记录在生成缓冲区中随报告发布，传输完成时用于计算年龄
+ */
+void hid_gamepad_set_sample_time(uint32_t sample_us);
+
+/**
+ * @brief 获取报告数据年龄统计
+ * @param age 输出统计
+ * @param reset 读取后清零
+ */
+void hid_gamepad_get_age(usb_report_age_t *age, bool reset);
+
 /**
  * @brief 检查USB设备是否已配置
  * @param busid USB总线ID
@@ -0,0 +1,144 @@
+/**
+ * @file usb_sof.c
+ * @brief USB帧同步节拍实现
+ * @details 协议栈端口没有把SOF中断转发给应用，这里直接用USB帧号寄存器锁相:
+ *          输入循环节拍后lead处为探测点，即期望的SOF时刻。
+ *          探测时帧号已变化说明SOF在探测点之前，节拍偏晚，下一周期缩短一个步长；
+ *          反之延长。步长在方向反转时减半、连续同向时加倍，收敛后在±1us内跟踪
+ */
+
+#include "usb_sof.h"
+#include "usb_app.h"
+#include "loop_timer.h"
+#include <board.h>
+
+/* 当前帧号低8位 */
+#define USB_SOF_FRAME()         ((uint8_t)USB0->FRMNUML)
+
+/* ================ 内部变量 ================ */
+
+static volatile bool sof_running = false;
+static uint32_t step = USB_SOF_STEP_MAX_US;     /* 当前调整步长(us) */
+static uint32_t lead_us = 0;
+static uint8_t tick_frame = 0;                  /* 节拍时的帧号 */
+static int8_t last_dir = 0;
+static uint8_t same_dir = 0;
+
+static volatile uint32_t stat_early = 0;
+static volatile uint32_t stat_late = 0;
+
+/* ================ 中断回调 ================ */
+
+/* 节拍: 记录帧号 */
+static void sof_tick(void)
+{
+    tick_frame = USB_SOF_FRAME();
+}
+
+/* 探测: 比较帧号判断相位误差方向，调整本周期长度 */
+static void sof_probe(void)
+{
+    int8_t dir;
+
+    if (USB_SOF_FRAME() != tick_frame)
+    {
+        dir = -1;       /* SOF已到，节拍偏晚 */
+        stat_early++;
+    }
+    else
+    {
+        dir = 1;        /* SOF未到，节拍偏早 */
+        stat_late++;
+    }
+
+    if (dir != last_dir)
+    {
+        step = (step / 2 > USB_SOF_STEP_MIN_US) ? step / 2 : USB_SOF_STEP_MIN_US;
+        same_dir = 0;
+    }
+    else if (++same_dir >= USB_SOF_WIDEN_COUNT)
+    {
+        step = (step * 2 < USB_SOF_STEP_MAX_US) ? step * 2 : USB_SOF_STEP_MAX_US;
+        same_dir = 0;
+    }
+    last_dir = dir;
+
+    loop_timer_trim(dir * (int32_t)step);
+}
+
+/* ================ 公共API ================ */
+
+/* 启动帧同步节拍 */
+rt_err_t usb_sof_start(uint32_t lead)
+{
+    rt_err_t ret;
+
+    if (lead + USB_SOF_STEP_MAX_US * 2 >= USB_SOF_FRAME_US || lead < USB_SOF_STEP_MAX_US)
+        return -RT_EINVAL;
+
+    /* 输入循环节拍改为一帧周期，由探测点锁相 */
+    ret = loop_timer_start(USB_SOF_FRAME_US);
+    if (ret != RT_EOK)
+        return ret;
+
+    step = USB_SOF_STEP_MAX_US;
+    lead_us = lead;
+    last_dir = 0;
+    same_dir = 0;
+    tick_frame = USB_SOF_FRAME();
+
+    ret = loop_timer_set_hooks(sof_tick, sof_probe, lead);
+    if (ret != RT_EOK)
+        return ret;
+
+    sof_running = true;
+    return RT_EOK;
+}
+
+/* 停止帧同步，节拍保持一帧周期继续自由运行 */
+void usb_sof_stop(void)
+{
+    if (!sof_running)
+        return;
+
+    if (loop_timer_running())
+        loop_timer_set_hooks(RT_NULL, RT_NULL, 0);
+    sof_running = false;
+}
+
+/* 获取同步状态 */
+void usb_sof_get_status(usb_sof_status_t *status)
+{
+    status->running = sof_running && loop_timer_running();
+    status->locked = status->running && (step <= USB_SOF_STEP_MIN_US);
+    status->lead_us = lead_us;
+    status->step_us = step;
+    status->early = stat_early;
+    status->late = stat_late;
+}
+
+/* ================ 调试命令 ================ */
+
+static int usb_sof(int argc, char **argv)
+{
+    usb_sof_status_t st;
+    usb_report_age_t age;
+    bool reset = (argc > 1 && rt_strcmp(argv[1], "reset") == 0);
+
+    usb_sof_get_status(&st);
+    hid_gamepad_get_age(&age, reset);
+
+    rt_kprintf("sof sync: %s%s, lead %d us, step %d us\n",
+               st.running ? "running" : "stopped",
+               st.locked ? " (locked)" : "", st.lead_us, st.step_us);
+    rt_kprintf("early %d, late %d\n", st.early, st.late);
+
+    if (age.count)
+    {
+        rt_kprintf("report age(us): %d reports, min %d, avg %d, max %d\n",
+                   age.count, age.min_us, (uint32_t)(age.sum_us / age.count), age.max_us);
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(usb_sof, show USB frame sync and report age: usb_sof [reset]);
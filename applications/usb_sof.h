@@ -0,0 +1,58 @@
+/**
+ * @file usb_sof.h
+ * @brief USB帧同步节拍
+ * @details 把输入循环节拍(loop_timer)设为1ms，相位锁定在主机SOF之前固定提前量处，
+ *          使报告总在主机轮询前由最新数据生成
+ */
+
+#ifndef __USB_SOF_H__
+#define __USB_SOF_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ================ 配置参数 ================ */
+
+#define USB_SOF_FRAME_US        1000    /* 全速USB帧周期 */
+#define USB_SOF_STEP_MAX_US     64      /* 相位捕获时的最大单次调整量 */
+#define USB_SOF_STEP_MIN_US     1       /* 锁定后的单次调整量 */
+#define USB_SOF_WIDEN_COUNT     4       /* 连续同向调整此次数后加大步长 */
+
+/* 同步状态 */
+typedef struct {
+    bool running;
+    bool locked;            /* 步长已收敛到最小值 */
+    uint32_t lead_us;       /* 节拍领先SOF的时间 */
+    uint32_t step_us;       /* 当前调整步长 */
+    uint32_t early;         /* 探测时SOF已到: 节拍偏晚的次数 */
+    uint32_t late;          /* 探测时SOF未到: 节拍偏早的次数 */
+} usb_sof_status_t;
+
+/**
+ * @brief 启动帧同步节拍，输入循环节拍以一帧周期重启
+ * @param lead_us 节拍领先SOF的时间，需覆盖采样、生成报告和启动IN传输的耗时
+ * @return RT_EOK成功
+ */
+rt_err_t usb_sof_start(uint32_t lead_us);
+
+/**
+ * @brief 停止帧同步，输入循环节拍继续自由运行
+ */
+void usb_sof_stop(void);
+
+/**
+ * @brief 获取同步状态
+ * @param status 输出状态
+ */
+void usb_sof_get_status(usb_sof_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USB_SOF_H__ */
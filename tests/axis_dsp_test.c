@@ -0,0 +1,148 @@
+/**
+ * @file axis_dsp_test.c
+ * @brief 四轴处理内核与原标量实现的逐位比对
+ * @details 同一份测试分别链接SIMD路径(DSP内联函数由stubs/board.h按架构语义实现)
+ *          和C路径，参考实现为改造前gamepad_app.c中的scale_axis()/axis_changed()。
+ *          缩放对全部65536个输入穷举，变化检测覆盖阈值边界和随机向量
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "axis_dsp.h"
+
+/* ================ 参考实现(原gamepad_app.c) ================ */
+
+static int8_t scale_axis(int16_t value)
+{
+    int32_t scaled = ((int32_t)value * 127) / 32768;
+    if (scaled > 127) scaled = 127;
+    if (scaled < -127) scaled = -127;
+    return (int8_t)scaled;
+}
+
+static bool axis_changed(int16_t new_val, int16_t old_val, uint16_t threshold)
+{
+    int32_t diff = (int32_t)new_val - (int32_t)old_val;
+    if (diff < 0) diff = -diff;
+    return diff > threshold;
+}
+
+/* ================ 测试 ================ */
+
+static unsigned long vectors = 0, failures = 0;
+
+/* 处理一组输入并与参考实现比对 */
+static void check(axis_pair_t in0, axis_pair_t in1, axis_pair_t last0, axis_pair_t last1, uint16_t thr)
+{
+    axis_pair_t in[AXIS_DSP_PAIRS] = {in0, in1};
+    axis_pair_t last[AXIS_DSP_PAIRS] = {last0, last1};
+    int8_t out[AXIS_DSP_AXES];
+    uint32_t mask, ref_mask = 0;
+    int bad = 0;
+
+    mask = axis_dsp_process(in, last, out, thr);
+
+    for (int i = 0; i < AXIS_DSP_AXES; i++)
+    {
+        int16_t v = (int16_t)(in[i / 2] >> ((i & 1) * 16));
+        int16_t l = (int16_t)(last[i / 2] >> ((i & 1) * 16));
+
+        if (out[i] != scale_axis(v))
+            bad = 1;
+        if (axis_changed(v, l, thr))
+            ref_mask |= 1u << i;
+    }
+
+    vectors++;
+    if (bad || mask != ref_mask)
+    {
+        if (failures++ < 10)
+        {
+            printf("FAIL in %08x %08x last %08x %08x thr %u: mask %x ref %x out %d %d %d %d\n",
+                   in0, in1, last0, last1, thr, mask, ref_mask, out[0], out[1], out[2], out[3]);
+        }
+    }
+}
+
+static uint32_t xorshift32(uint32_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+int main(int argc, char **argv)
+{
+    static const int16_t edges[] = {
+        -32768, -32767, -32766, -16385, -16384, -259, -258, -257, -1, 0, 1, 257, 258, 259,
+        16383, 16384, 32765, 32766, 32767,
+    };
+    static const uint16_t thresholds[] = {0, 1, 2, 255, 256, 499, 500, 501, 16383, 32765, 32766};
+    const int n_edges = sizeof(edges) / sizeof(edges[0]);
+    const int n_thr = sizeof(thresholds) / sizeof(thresholds[0]);
+    unsigned long random = (argc > 1) ? strtoul(argv[1], NULL, 0) : 2000000;
+    uint32_t seed = 0x12345678;
+
+    /* 缩放穷举: 四个通道各自走遍全部输入 */
+    for (int32_t v = -32768; v <= 32767; v++)
+    {
+        int16_t w = (int16_t)~v;
+
+        check(axis_pack((int16_t)v, w), axis_pack(w, (int16_t)v), 0, 0, 32766);
+    }
+
+    /* 变化检测边界: 饱和差值、差值恰为阈值及阈值+1 */
+    for (int t = 0; t < n_thr; t++)
+    {
+        for (int a = 0; a < n_edges; a++)
+        {
+            for (int b = 0; b < n_edges; b++)
+            {
+                check(axis_pack(edges[a], edges[b]), axis_pack(edges[b], edges[a]),
+                      axis_pack(edges[b], edges[a]), axis_pack(edges[a], edges[b]), thresholds[t]);
+            }
+
+            for (int d = -1; d <= 1; d++)
+            {
+                int32_t base = edges[a];
+                int32_t up = base + thresholds[t] + d;
+                int32_t down = base - thresholds[t] - d;
+
+                if (up <= 32767 && down >= -32768)
+                {
+                    check(axis_pack((int16_t)up, (int16_t)down), axis_pack((int16_t)down, (int16_t)up),
+                          axis_pack((int16_t)base, (int16_t)base), axis_pack((int16_t)base, (int16_t)base),
+                          thresholds[t]);
+                }
+            }
+        }
+    }
+
+    /* 随机向量: 一半为相近的值(阈值附近)，一半完全随机 */
+    for (unsigned long n = 0; n < random; n++)
+    {
+        uint32_t in0 = xorshift32(&seed), in1 = xorshift32(&seed);
+        uint32_t last0, last1;
+        uint16_t thr = (uint16_t)(xorshift32(&seed) % 32767);
+
+        if (n & 1)
+        {
+            thr &= 0x3FF;
+            last0 = in0 + (xorshift32(&seed) & 0x07FF07FF);
+            last1 = in1 - (xorshift32(&seed) & 0x07FF07FF);
+        }
+        else
+        {
+            last0 = xorshift32(&seed);
+            last1 = xorshift32(&seed);
+        }
+
+        check(in0, in1, last0, last1, thr);
+    }
+
+    printf("axis_dsp_test (%s kernel): %lu vectors, %lu mismatches\n",
+           AXIS_DSP_USE_SIMD ? "SIMD" : "C", vectors, failures);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,251 @@
+/**
+ * @file axis_filter_bench.c
+ * @brief 回放采集数据评估摇杆滤波
+ * @details 与 axis_filter bench 命令相同的指标，但输入来自capture导出的原始帧，
+ *          同一份数据可反复用不同参数比较:
+ *          按报告周期取最近OVERSAMPLE_FRAMES帧的boxcar平均(与固件读取时相同)，
+ *          按未校准的满量程映射(adc - 32768)得到轴值，再以帧时间差调用axis_filter_step。
+ *
+ *          抖动 = 相邻输出平均变化量(count/sample)，静止数据上即为残余噪声；
+ *          延迟 = 使 mean|滤波输出[n] - 输入[n-L]| 最小的L(抛物线插值到小数)，
+ *          只在轴有明显运动时统计
+ *
+ *   axis_filter_bench [-f min_cutoff_mhz beta_mhz d_cutoff_mhz] [-t period_us] [-l max_lag_ms] trace...
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+#include "oversample.h"
+#include "axis_filter.h"
+
+#define BENCH_PERIOD_US     1000    /* 默认报告周期，与GAMEPAD_PERIOD_US一致 */
+#define BENCH_LAG_MAX       64      /* 延迟搜索范围(报告周期) */
+#define BENCH_MOTION_MIN    4096    /* 输入峰峰值低于此值视为静止，不估计延迟 */
+
+static const char *const axis_names[TRACE_AXES] = {"LX", "LY", "RX", "RY"};
+
+/* axis_filter.c的bench命令引用，主机上不会调用 */
+rt_err_t joystick_read(joystick_data_t *left, joystick_data_t *right)
+{
+    return -RT_ENOSYS;
+}
+
+/* 原始值 -> 轴值，与未校准时的映射一致 */
+static int16_t to_axis(uint32_t raw)
+{
+    int32_t v = (int32_t)raw - 32768;
+
+    if (v > 32767) v = 32767;
+    if (v < -32768) v = -32768;
+    return (int16_t)v;
+}
+
+static double mean_abs_diff(const int16_t *out, const int16_t *in, uint32_t count, uint32_t lag)
+{
+    double sum = 0;
+
+    for (uint32_t n = lag; n < count; n++)
+        sum += abs(out[n] - in[n - lag]);
+    return sum / (count - lag);
+}
+
+/* 延迟(报告周期数)，无运动时返回负值 */
+static double estimate_lag(const int16_t *out, const int16_t *in, uint32_t count)
+{
+    int16_t lo = INT16_MAX, hi = INT16_MIN;
+    double e[BENCH_LAG_MAX + 1];
+    uint32_t best = 0;
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        if (in[n] < lo) lo = in[n];
+        if (in[n] > hi) hi = in[n];
+    }
+    if (hi - lo < BENCH_MOTION_MIN || count <= 2 * BENCH_LAG_MAX)
+        return -1;
+
+    for (uint32_t l = 0; l <= BENCH_LAG_MAX; l++)
+    {
+        e[l] = mean_abs_diff(out, in, count, l);
+        if (e[l] < e[best])
+            best = l;
+    }
+
+    /* 在最小值两侧做抛物线插值 */
+    if (best > 0 && best < BENCH_LAG_MAX)
+    {
+        double den = e[best - 1] - 2 * e[best] + e[best + 1];
+
+        if (den > 0)
+            return best + 0.5 * (e[best - 1] - e[best + 1]) / den;
+    }
+    return best;
+}
+
+/* 回放一个文件，返回各轴中最大的延迟(ms) */
+static double bench(const char *path, const trace_t *trace, uint32_t period_us)
+{
+    uint32_t count = 0, cap, f = 0, last_us = 0;
+    int16_t (*in)[TRACE_AXES], (*out)[TRACE_AXES];
+    axis_filter_state_t st[TRACE_AXES] = {0};
+    double max_lag = 0;
+
+    if (trace->frame_count < OVERSAMPLE_FRAMES)
+    {
+        printf("%s: too few frames\n", path);
+        return INFINITY;
+    }
+
+    cap = trace->frames[trace->frame_count - 1].time_us / period_us + 1;
+    in = malloc(cap * sizeof(*in));
+    out = malloc(cap * sizeof(*out));
+
+    /* 每个报告周期读一次最近的帧，与固件主循环相同 */
+    for (uint32_t t = trace->frames[OVERSAMPLE_FRAMES - 1].time_us; count < cap; t += period_us)
+    {
+        oversample_t os;
+        uint32_t avg[OVERSAMPLE_AXES], dt;
+
+        while (f + 1 < trace->frame_count && trace->frames[f + 1].time_us <= t)
+            f++;
+        if (f + 1 == trace->frame_count && trace->frames[f].time_us + period_us < t)
+            break;
+        if (f + 1 < OVERSAMPLE_FRAMES)
+            continue;
+
+        oversample_reset(&os);
+        for (uint32_t k = 0; k < OVERSAMPLE_FRAMES; k++)
+        {
+            uint32_t v[OVERSAMPLE_AXES];
+
+            for (int a = 0; a < TRACE_AXES; a++)
+                v[a] = trace->frames[f - k].v[a];
+            oversample_add(&os, v);
+        }
+        oversample_get(&os, avg);
+
+        /* 与axis_filter_apply相同: 长时间无数据后重新初始化 */
+        dt = count ? t - last_us : 0;
+        if (dt > AXIS_FILTER_RESET_US)
+        {
+            for (int a = 0; a < TRACE_AXES; a++)
+                st[a].init = 0;
+        }
+        last_us = t;
+
+        for (int a = 0; a < TRACE_AXES; a++)
+        {
+            in[count][a] = to_axis(avg[a]);
+            out[count][a] = axis_filter_step(&st[a], in[count][a], dt);
+        }
+        count++;
+    }
+
+    printf("%s: %u reports every %u us\n", path, count, period_us);
+
+    for (int a = 0; a < TRACE_AXES; a++)
+    {
+        int16_t *x = malloc(count * sizeof(int16_t)), *y = malloc(count * sizeof(int16_t));
+        double d_in = 0, d_out = 0, lag;
+
+        for (uint32_t n = 0; n < count; n++)
+        {
+            x[n] = in[n][a];
+            y[n] = out[n][a];
+            if (n > 0)
+            {
+                d_in += abs(x[n] - x[n - 1]);
+                d_out += abs(y[n] - y[n - 1]);
+            }
+        }
+        d_in /= count > 1 ? count - 1 : 1;
+        d_out /= count > 1 ? count - 1 : 1;
+
+        lag = estimate_lag(y, x, count);
+        if (lag < 0)
+        {
+            printf("  %s: jitter raw %.1f filtered %.1f (count/sample), no motion for lag\n",
+                   axis_names[a], d_in, d_out);
+        }
+        else
+        {
+            lag = lag * period_us / 1000.0;
+            if (lag > max_lag)
+                max_lag = lag;
+            printf("  %s: jitter raw %.1f filtered %.1f (count/sample), lag %.2f ms\n",
+                   axis_names[a], d_in, d_out, lag);
+        }
+        free(x);
+        free(y);
+    }
+
+    free(in);
+    free(out);
+    return max_lag;
+}
+
+int main(int argc, char **argv)
+{
+    axis_filter_config_t cfg = *axis_filter_get_config();
+    uint32_t period_us = BENCH_PERIOD_US;
+    double max_lag_ms = INFINITY;
+    int failures = 0, files = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        trace_t trace;
+        double lag;
+
+        if (strcmp(argv[i], "-f") == 0 && i + 3 < argc)
+        {
+            cfg.min_cutoff_mhz = (uint32_t)atoi(argv[++i]);
+            cfg.beta_mhz = (uint32_t)atoi(argv[++i]);
+            cfg.d_cutoff_mhz = (uint32_t)atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            int t = atoi(argv[++i]);
+
+            period_us = t > 0 ? (uint32_t)t : BENCH_PERIOD_US;
+            continue;
+        }
+        if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+        {
+            max_lag_ms = atof(argv[++i]);
+            continue;
+        }
+
+        if (files++ == 0)
+        {
+            axis_filter_set_config(&cfg);
+            printf("min_cutoff %u mHz, beta %u mHz/(count/ms), d_cutoff %u mHz\n",
+                   cfg.min_cutoff_mhz, cfg.beta_mhz, cfg.d_cutoff_mhz);
+        }
+        if (trace_load(argv[i], &trace) != 0)
+        {
+            failures++;
+            continue;
+        }
+
+        lag = bench(argv[i], &trace, period_us);
+        if (lag > max_lag_ms)
+        {
+            printf("FAIL %s: lag %.2f ms above %.2f ms\n", argv[i], lag, max_lag_ms);
+            failures++;
+        }
+        trace_free(&trace);
+    }
+
+    if (files == 0)
+    {
+        fprintf(stderr, "usage: axis_filter_bench [-f min_cutoff_mhz beta_mhz d_cutoff_mhz] "
+                        "[-t period_us] [-l max_lag_ms] trace...\n");
+        return 2;
+    }
+
+    return failures ? 1 : 0;
+}
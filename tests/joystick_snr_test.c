@@ -0,0 +1,189 @@
+/**
+ * @file joystick_snr_test.c
+ * @brief 摇杆过采样的信噪比评估
+ * @details 回放capture导出的原始帧，用固件相同的boxcar平均(oversample.h)得到过采样值，
+ *          与单帧值比较噪声和信噪比。采集到的帧已经过LPADC硬件平均，这里只评估软件抽取的增益。
+ *
+ *          参考信号取单帧值的Savitzky-Golay二次平滑(49帧，约24ms)，能跟随摇杆运动而不滞后；
+ *          噪声 = 值 - 参考。过采样值的噪声与同样经过boxcar的参考比较，摇杆运动带来的延迟不计入噪声。
+ *          快速拨杆的起止拐点处平滑参考无法跟随，拐点前后一个窗口内的帧不参与统计
+ *
+ *   joystick_snr_test [-m min_gain_db] trace...
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+#include "oversample.h"
+
+#define REF_HALF    24      /* 参考平滑窗口半宽(帧) */
+#define REF_BEND    24      /* 参考信号二阶差分超过此值(原始值/帧^2)视为拐点 */
+
+static const char *const axis_names[TRACE_AXES] = {"LX", "LY", "RX", "RY"};
+
+/* Savitzky-Golay二次/三次平滑系数，窗口2m+1 */
+static double sg_coef(int m, int k)
+{
+    return 3.0 * (3.0 * m * m + 3.0 * m - 1.0 - 5.0 * k * k) /
+           ((2.0 * m + 1.0) * (2.0 * m - 1.0) * (2.0 * m + 3.0));
+}
+
+/* 对最近OVERSAMPLE_FRAMES帧求boxcar平均，与固件读取环形缓冲区时相同 */
+static void boxcar(const uint32_t (*in)[OVERSAMPLE_AXES], uint32_t n, uint32_t out[OVERSAMPLE_AXES])
+{
+    oversample_t os;
+
+    oversample_reset(&os);
+    for (uint32_t k = 0; k < OVERSAMPLE_FRAMES; k++)
+        oversample_add(&os, in[n - k]);
+    oversample_get(&os, out);
+}
+
+/* 评估一个文件，返回各轴中最小的增益(dB) */
+static double evaluate(const char *path, const trace_t *trace)
+{
+    uint32_t count = trace->frame_count;
+    uint32_t (*raw)[OVERSAMPLE_AXES] = malloc(count * sizeof(*raw));
+    uint32_t (*ref)[OVERSAMPLE_AXES] = malloc(count * sizeof(*ref));
+    uint8_t *skip = calloc(count, 1);
+    double min_gain = INFINITY;
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        for (int a = 0; a < TRACE_AXES; a++)
+            raw[n][a] = trace->frames[n].v[a];
+    }
+
+    /* 参考信号四舍五入到整数，以便同样用固件的整数boxcar处理 */
+    for (uint32_t n = REF_HALF; n + REF_HALF < count; n++)
+    {
+        for (int a = 0; a < TRACE_AXES; a++)
+        {
+            double s = 0;
+
+            for (int k = -REF_HALF; k <= REF_HALF; k++)
+                s += sg_coef(REF_HALF, k) * raw[n + k][a];
+            ref[n][a] = (uint32_t)lrint(s);
+        }
+    }
+
+    /* 标记拐点附近的帧(任一轴) */
+    for (uint32_t n = REF_HALF + 1; n + REF_HALF + 1 < count; n++)
+    {
+        for (int a = 0; a < TRACE_AXES; a++)
+        {
+            int32_t bend = (int32_t)ref[n + 1][a] - 2 * (int32_t)ref[n][a] + (int32_t)ref[n - 1][a];
+
+            if (abs(bend) > REF_BEND)
+            {
+                for (uint32_t k = n - REF_HALF; k <= n + REF_HALF + OVERSAMPLE_FRAMES && k < count; k++)
+                    skip[k] = 1;
+            }
+        }
+    }
+
+    {
+        uint32_t skipped = 0;
+
+        for (uint32_t n = 0; n < count; n++)
+            skipped += skip[n];
+        printf("%s: %u frames at %u Hz, oversample %d frames, %u frames near stick transients skipped\n",
+               path, count, trace->hdr.adc_rate_hz, OVERSAMPLE_FRAMES, skipped);
+    }
+
+    for (int a = 0; a < TRACE_AXES; a++)
+    {
+        double n1 = 0, n2 = 0, sig = 0, mean = 0, snr1, snr2, gain;
+        uint32_t samples = 0;
+
+        for (uint32_t n = REF_HALF + OVERSAMPLE_FRAMES; n + REF_HALF < count; n++)
+        {
+            if (!skip[n])
+                mean += ref[n][a], samples++;
+        }
+        if (samples == 0)
+        {
+            printf("  no usable frames\n");
+            min_gain = -INFINITY;
+            break;
+        }
+        mean /= samples;
+
+        for (uint32_t n = REF_HALF + OVERSAMPLE_FRAMES; n + REF_HALF < count; n++)
+        {
+            uint32_t os_raw[OVERSAMPLE_AXES], os_ref[OVERSAMPLE_AXES];
+            double d1 = (double)raw[n][a] - ref[n][a];
+            double d2;
+
+            if (skip[n])
+                continue;
+            boxcar((const uint32_t (*)[OVERSAMPLE_AXES])raw, n, os_raw);
+            boxcar((const uint32_t (*)[OVERSAMPLE_AXES])ref, n, os_ref);
+            d2 = (double)os_raw[a] - os_ref[a];
+
+            n1 += d1 * d1;
+            n2 += d2 * d2;
+            sig += (ref[n][a] - mean) * (ref[n][a] - mean);
+        }
+
+        n1 = sqrt(n1 / samples);
+        n2 = sqrt(n2 / samples);
+        sig = sqrt(sig / samples);
+        gain = 20.0 * log10(n1 / n2);
+        snr1 = 20.0 * log10(sig / n1);
+        snr2 = 20.0 * log10(sig / n2);
+        if (gain < min_gain)
+            min_gain = gain;
+
+        printf("  %s: noise std single %.1f oversampled %.1f (gain %.1f dB), SNR %.1f -> %.1f dB\n",
+               axis_names[a], n1, n2, gain, snr1, snr2);
+    }
+
+    free(raw);
+    free(ref);
+    free(skip);
+    return min_gain;
+}
+
+int main(int argc, char **argv)
+{
+    double min_gain_db = -INFINITY;
+    int failures = 0, files = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        trace_t trace;
+        double gain;
+
+        if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            min_gain_db = atof(argv[++i]);
+            continue;
+        }
+
+        files++;
+        if (trace_load(argv[i], &trace) != 0)
+        {
+            failures++;
+            continue;
+        }
+
+        gain = evaluate(argv[i], &trace);
+        if (gain < min_gain_db)
+        {
+            printf("FAIL %s: gain %.1f dB below %.1f dB\n", argv[i], gain, min_gain_db);
+            failures++;
+        }
+        trace_free(&trace);
+    }
+
+    if (files == 0)
+    {
+        fprintf(stderr, "usage: joystick_snr_test [-m min_gain_db] trace...\n");
+        return 2;
+    }
+
+    return failures ? 1 : 0;
+}
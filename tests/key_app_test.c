@@ -0,0 +1,266 @@
+/**
+ * @file key_app_test.c
+ * @brief 矩阵扫描主机测试
+ * @details 用PIN设备后端编译key_app.c，rt_pin_xxx由本文件模拟4x4矩阵:
+ *          驱动为低电平的列经按下的按键把对应行拉低。检查全部16位按键组合都能被
+ *          一次扫描完整读出，组合键在同一次状态更新中产生事件，鬼键不会被上报
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "key_app.h"
+
+extern int (*const stub_init_key_init)(void);
+extern rt_uint32_t stub_time_us;
+
+/* ================ 矩阵模拟 ================ */
+
+static rt_base_t col_pins[4], row_pins[4];
+static rt_uint8_t col_count = 0, row_count = 0;
+static rt_uint8_t col_level[4] = {PIN_HIGH, PIN_HIGH, PIN_HIGH, PIN_HIGH};
+static rt_uint16_t pressed = 0;     /* bit(col*4+row) */
+static int diodes = 1;              /* 0: 无二极管矩阵，按键之间可以串通 */
+
+/* key_init按C1..C4、R1..R4的顺序配置引脚 */
+void rt_pin_mode(rt_base_t pin, rt_uint8_t mode)
+{
+    if (mode == PIN_MODE_OUTPUT && col_count < 4)
+        col_pins[col_count++] = pin;
+    else if (mode == PIN_MODE_INPUT_PULLUP && row_count < 4)
+        row_pins[row_count++] = pin;
+}
+
+void rt_pin_write(rt_base_t pin, rt_uint8_t value)
+{
+    for (int c = 0; c < 4; c++)
+    {
+        if (col_pins[c] == pin)
+            col_level[c] = value;
+    }
+}
+
+/* 无二极管时按连通关系传播低电平: 节点0-3为列，4-7为行 */
+static rt_uint8_t matrix_low_nodes(void)
+{
+    rt_uint8_t low = 0, prev;
+
+    for (int c = 0; c < 4; c++)
+    {
+        if (col_level[c] == PIN_LOW)
+            low |= (rt_uint8_t)(1u << c);
+    }
+
+    do
+    {
+        prev = low;
+        for (int k = 0; k < 16; k++)
+        {
+            rt_uint8_t a = (rt_uint8_t)(1u << (k / 4)), b = (rt_uint8_t)(1u << (4 + k % 4));
+
+            if ((pressed & (1u << k)) && (low & (a | b)))
+                low |= a | b;
+        }
+    } while (low != prev);
+
+    return low;
+}
+
+rt_int8_t rt_pin_read(rt_base_t pin)
+{
+    for (int r = 0; r < 4; r++)
+    {
+        if (row_pins[r] != pin)
+            continue;
+
+        if (!diodes)
+            return (matrix_low_nodes() & (1u << (4 + r))) ? PIN_LOW : PIN_HIGH;
+
+        for (int c = 0; c < 4; c++)
+        {
+            if (col_level[c] == PIN_LOW && (pressed & (1u << (c * 4 + r))))
+                return PIN_LOW;
+        }
+        return PIN_HIGH;
+    }
+
+    return PIN_HIGH;
+}
+
+rt_err_t rt_pin_attach_irq(rt_base_t pin, rt_uint8_t mode, void (*hdr)(void *args), void *args)
+{
+    return RT_EOK;
+}
+
+rt_err_t rt_pin_irq_enable(rt_base_t pin, rt_uint32_t enabled)
+{
+    return RT_EOK;
+}
+
+/* ================ 测试 ================ */
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                    \
+    do {                                                    \
+        if (!(cond)) {                                      \
+            if (failures++ < 10)                            \
+                printf("FAIL %s:%d: ", __FILE__, __LINE__), \
+                printf(__VA_ARGS__), printf("\n");          \
+        }                                                   \
+    } while (0)
+
+/* 两列以上共用两行以上时构成矩形，无二极管矩阵中会出现鬼键 */
+static int has_rectangle(rt_uint16_t keys)
+{
+    for (int a = 0; a < 4; a++)
+    {
+        for (int b = a + 1; b < 4; b++)
+        {
+            rt_uint8_t common = (keys >> (a * 4)) & (keys >> (b * 4)) & 0xF;
+
+            if (common & (common - 1))
+                return 1;
+        }
+    }
+    return 0;
+}
+
+/* 取出全部事件，返回按下/释放的按键位图 */
+static void drain_events(rt_uint16_t *down, rt_uint16_t *up, int *same_time)
+{
+    key_event_t evt;
+    rt_uint32_t first = 0;
+    int n = 0;
+
+    *down = *up = 0;
+    *same_time = 1;
+    while (key_event_peek(&evt))
+    {
+        if (n++ == 0)
+            first = evt.time_us;
+        else if (evt.time_us != first)
+            *same_time = 0;
+
+        if (evt.pressed)
+            *down |= (rt_uint16_t)(1u << evt.key);
+        else
+            *up |= (rt_uint16_t)(1u << evt.key);
+        key_event_pop();
+    }
+}
+
+/* 一次扫描读出完整位图，key_read()保持旧接口的最小索引语义 */
+static void test_scan_all_patterns(void)
+{
+    diodes = 1;
+    for (uint32_t p = 0; p <= 0xFFFF; p++)
+    {
+        rt_uint16_t got;
+        rt_uint8_t idx;
+
+        pressed = (rt_uint16_t)p;
+        got = key_scan();
+        CHECK(got == pressed, "key_scan %04x -> %04x", pressed, got);
+
+        idx = key_read();
+        if (p == 0)
+            CHECK(idx == KEY_NONE, "key_read idle -> %d", idx);
+        else
+            CHECK(idx == __builtin_ctz(p), "key_read %04x -> %d", pressed, idx);
+
+        for (int c = 0; c < 4; c++)
+            CHECK(col_level[c] == PIN_HIGH, "column %d left low after scan", c);
+    }
+}
+
+/* 组合键: 所有无矩形的组合在同一次状态更新中全部上报，事件时间戳相同 */
+static void test_chords(void)
+{
+    rt_uint16_t down, up;
+    int same, chords = 0;
+
+    diodes = 1;
+    for (uint32_t p = 1; p <= 0xFFFF; p++)
+    {
+        rt_uint16_t state;
+
+        if (has_rectangle((rt_uint16_t)p))
+            continue;
+        chords++;
+
+        stub_time_us += 1000;
+        pressed = (rt_uint16_t)p;
+        state = key_get_state();
+        CHECK(state == pressed, "chord %04x -> state %04x", pressed, state);
+        drain_events(&down, &up, &same);
+        CHECK(down == pressed && up == 0 && same, "chord %04x -> events down %04x up %04x", pressed, down, up);
+
+        /* 释放需经过完整的消抖窗口 */
+        pressed = 0;
+        for (int n = 0; n < KEY_DEBOUNCE_SAMPLES; n++)
+        {
+            stub_time_us += 1000;
+            state = key_get_state();
+        }
+        CHECK(state == 0, "release of %04x -> state %04x", (rt_uint16_t)p, state);
+        drain_events(&down, &up, &same);
+        CHECK(down == 0 && up == (rt_uint16_t)p, "release of %04x -> events down %04x up %04x",
+              (rt_uint16_t)p, down, up);
+    }
+
+    printf("chords: %d patterns without rectangles checked\n", chords);
+}
+
+/* 无二极管矩阵: 三个角按下产生的第四角鬼键不被上报，持续按住时只计数一次 */
+static void test_ghost(void)
+{
+    const rt_uint16_t k00 = 1u << 0, k01 = 1u << 1, k10 = 1u << 4, k11 = 1u << 5;
+    rt_uint16_t state, down, up;
+    rt_uint32_t ghosts;
+    int same;
+
+    diodes = 0;
+    pressed = k00 | k01 | k10;
+    CHECK(key_scan() == (k00 | k01 | k10 | k11), "matrix model does not ghost");
+
+    /* 依次按下: 前两个键正常上报，第三个键与鬼键同时出现时暂缓 */
+    pressed = k00;
+    state = key_get_state();
+    pressed = k00 | k01;
+    state = key_get_state();
+    CHECK(state == (k00 | k01), "column chord -> %04x", state);
+
+    ghosts = key_ghost_count();
+    pressed = k00 | k01 | k10;
+    for (int n = 0; n < 100; n++)
+    {
+        state = key_get_state();
+        CHECK(!(state & k11), "ghost key reported: %04x", state);
+    }
+    CHECK(key_ghost_count() - ghosts == 1, "ghost counted %d times while held",
+          key_ghost_count() - ghosts);
+
+    pressed = 0;
+    for (int n = 0; n < KEY_DEBOUNCE_SAMPLES; n++)
+        state = key_get_state();
+    CHECK(state == 0, "ghost release -> %04x", state);
+    drain_events(&down, &up, &same);
+    CHECK(!(down & k11), "ghost key produced an event");
+}
+
+int main(void)
+{
+    stub_init_key_init();
+    if (col_count != 4 || row_count != 4)
+    {
+        printf("FAIL: key_init configured %d columns and %d rows\n", col_count, row_count);
+        return 1;
+    }
+
+    test_scan_all_patterns();
+    test_chords();
+    test_ghost();
+
+    printf("key_app_test: %s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
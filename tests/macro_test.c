@@ -0,0 +1,260 @@
+/**
+ * @file macro_test.c
+ * @brief 输入宏录制回放主机测试
+ * @details 以1ms节拍录制30s合成输入(按钮、方向键随机按下，摇杆静止抖动、缓慢移动和快速拨到满行程)，
+ *          再从RAM回放，逐节拍比对: 按钮和方向键完全一致(时序准确)，
+ *          轴值误差不超过MACRO_AXIS_DEADBAND且回中和满行程准确，录制没有被截断。
+ *          保存时由flash_store_program桩取得写入的数据，检查头部并输出占用字节数
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "macro.h"
+#include "loop_timer.h"
+#include "usb_app.h"
+
+#define TEST_PERIOD_US  1000
+#define TEST_TICKS      30000   /* 30s */
+#define TEST_NOISE      0.35    /* 轴值噪声(报告单位)，约为量化边界附近的抖动 */
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                    \
+    do {                                                    \
+        if (!(cond)) {                                      \
+            if (failures++ < 10)                            \
+                printf("FAIL %s:%d: ", __FILE__, __LINE__), \
+                printf(__VA_ARGS__), printf("\n");          \
+        }                                                   \
+    } while (0)
+
+/* ================ 桩 ================ */
+
+uint32_t loop_timer_period(void)
+{
+    return TEST_PERIOD_US;
+}
+
+uint32_t loop_timer_tick(void)
+{
+    return 0;
+}
+
+/* 保存的宏写到这里，flash槽位地址在主机上不可访问 */
+static uint8_t saved[MACRO_SLOT_SIZE];
+static uint32_t saved_size = 0;
+
+rt_err_t flash_store_erase(uint32_t addr, uint32_t size)
+{
+    memset(saved, 0xFF, sizeof(saved));
+    saved_size = 0;
+    return RT_EOK;
+}
+
+rt_err_t flash_store_program(uint32_t addr, const void *data, uint32_t size)
+{
+    if (size > sizeof(saved))
+        return -RT_EINVAL;
+    memcpy(saved, data, size);
+    saved_size = size;
+    return RT_EOK;
+}
+
+/* ================ 合成输入 ================ */
+
+static macro_frame_t input[TEST_TICKS];
+
+static uint32_t rng_state = 0x9E3779B9;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static double rng_uniform(void)
+{
+    return (rng() + 0.5) / 4294967296.0;
+}
+
+/* 近似高斯噪声: 4个均匀分布之和 */
+static double rng_noise(double std)
+{
+    return (rng_uniform() + rng_uniform() + rng_uniform() + rng_uniform() - 2.0) * std * 1.732;
+}
+
+/* 摇杆位置(-1~1): 每段随机选静止、缓慢移动或快速拨杆 */
+static void gen_axis(int axis)
+{
+    uint32_t n = 0;
+    double pos = 0;
+
+    while (n < TEST_TICKS)
+    {
+        uint32_t len = 200 + rng() % 1500;
+        uint32_t kind = rng() % 3;
+        double target = (rng() % 2) ? 1.0 : -1.0;
+        double start = pos;
+
+        for (uint32_t k = 0; k < len && n < TEST_TICKS; k++, n++)
+        {
+            double v;
+            long q;
+
+            if (kind == 0)
+                pos = 0;                                            /* 回中静止 */
+            else if (kind == 1)
+                pos = start + (target * 0.6 - start) * k / len;     /* 缓慢移动 */
+            else
+                pos = k < 20 ? start + (target - start) * k / 20 : target;  /* 20ms拨到满行程 */
+
+            v = pos * 127.0 + rng_noise(TEST_NOISE);
+            q = (long)v;                /* 与axis_dsp相同，向零截断 */
+            if (q > 127) q = 127;
+            if (q < -127) q = -127;
+            input[n].axes[axis] = (int8_t)q;
+        }
+    }
+}
+
+static void gen_input(void)
+{
+    uint32_t next_button = 0, next_hat = 0;
+    uint16_t buttons = 0;
+    uint8_t hat = GAMEPAD_HAT_CENTER;
+
+    for (int a = 0; a < 4; a++)
+        gen_axis(a);
+
+    for (uint32_t n = 0; n < TEST_TICKS; n++)
+    {
+        if (n == next_button)
+        {
+            buttons ^= (uint16_t)(1u << (rng() % 16));
+            next_button = n + 1 + rng() % 300;
+        }
+        if (n == next_hat)
+        {
+            hat = (rng() % 2) ? GAMEPAD_HAT_CENTER : (uint8_t)(rng() % 8);
+            next_hat = n + 1 + rng() % 600;
+        }
+        input[n].buttons = buttons;
+        input[n].hat = hat;
+    }
+}
+
+/* 不加死区时事件流的字节数，用于对比 */
+static uint32_t bytes_without_deadband(void)
+{
+    uint32_t bytes = 0, last = 0;
+
+    for (uint32_t n = 1; n < TEST_TICKS; n++)
+    {
+        const macro_frame_t *a = &input[n - 1], *b = &input[n];
+        uint32_t fields = ((a->buttons ^ b->buttons) & 0x00FF ? 1 : 0) + ((a->buttons ^ b->buttons) & 0xFF00 ? 1 : 0) +
+                          (a->hat != b->hat);
+
+        for (int i = 0; i < 4; i++)
+            fields += a->axes[i] != b->axes[i];
+        if (fields)
+        {
+            bytes += (n - last < 0x80 ? 1 : n - last < 0x4000 ? 2 : 3) + 1 + fields;
+            last = n;
+        }
+    }
+    return bytes;
+}
+
+static void frame_neutral(macro_frame_t *f)
+{
+    memset(f, 0, sizeof(*f));
+    f->hat = GAMEPAD_HAT_CENTER;
+}
+
+/* ================ 测试 ================ */
+
+static void test_record(uint32_t tick)
+{
+    macro_frame_t frame;
+    const macro_header_t *hdr = (const macro_header_t *)saved;
+
+    CHECK(macro_record_start() == RT_EOK, "record start");
+    for (uint32_t n = 0; n < TEST_TICKS; n++)
+    {
+        frame = input[n];
+        macro_process(tick + n, &frame);
+        CHECK(memcmp(&frame, &input[n], sizeof(frame)) == 0, "recording changed the output at %u", n);
+    }
+    macro_stop();
+    frame_neutral(&frame);
+    macro_process(tick + TEST_TICKS, &frame);
+    CHECK(!macro_is_active(), "recording did not stop");
+
+    CHECK(macro_save(0) == RT_EOK, "save");
+    CHECK(hdr->magic == MACRO_MAGIC && hdr->version == MACRO_VERSION, "saved header");
+    CHECK(hdr->duration == TEST_TICKS, "recorded %u ticks of %u (truncated?)", hdr->duration, TEST_TICKS);
+    CHECK(hdr->period_us == TEST_PERIOD_US, "period %u", hdr->period_us);
+    CHECK(saved_size % FLASH_STORE_PHRASE_SIZE == 0 && saved_size >= sizeof(*hdr) + hdr->size,
+          "saved %u bytes for %u", saved_size, (uint32_t)sizeof(*hdr) + hdr->size);
+
+    printf("recorded %u ms, %u events, %u bytes of %u (%u without axis deadband)\n",
+           hdr->duration * hdr->period_us / 1000, hdr->events, (uint32_t)sizeof(*hdr) + hdr->size,
+           (uint32_t)MACRO_SLOT_SIZE, (uint32_t)sizeof(*hdr) + bytes_without_deadband());
+}
+
+/* 回放loops遍并逐节拍比对 */
+static void test_play(uint32_t tick, uint32_t loops)
+{
+    uint32_t axis_err_max = 0;
+
+    CHECK(macro_play_start(MACRO_SLOT_RAM, loops) == RT_EOK, "play start");
+    for (uint32_t p = 0; p < TEST_TICKS * loops; p++)
+    {
+        const macro_frame_t *in = &input[p % TEST_TICKS];
+        macro_frame_t frame;
+
+        frame_neutral(&frame);
+        macro_process(tick + p, &frame);
+        CHECK(macro_is_active(), "playback stopped at tick %u", p);
+        CHECK(frame.buttons == in->buttons, "tick %u buttons %04x expected %04x", p, frame.buttons, in->buttons);
+        CHECK(frame.hat == in->hat, "tick %u hat %u expected %u", p, frame.hat, in->hat);
+
+        for (int i = 0; i < 4; i++)
+        {
+            uint32_t err = (uint32_t)abs(frame.axes[i] - in->axes[i]);
+
+            if (err > axis_err_max)
+                axis_err_max = err;
+            CHECK(err <= MACRO_AXIS_DEADBAND, "tick %u axis %d = %d expected %d", p, i, frame.axes[i], in->axes[i]);
+            if (in->axes[i] == 0 || abs(in->axes[i]) == 127)
+                CHECK(frame.axes[i] == in->axes[i], "tick %u axis %d = %d expected exactly %d",
+                      p, i, frame.axes[i], in->axes[i]);
+        }
+    }
+
+    {
+        macro_frame_t frame;
+
+        frame_neutral(&frame);
+        macro_process(tick + TEST_TICKS * loops, &frame);
+        CHECK(!macro_is_active(), "playback did not end after %u loops", loops);
+    }
+
+    printf("played %u loop(s), max axis error %u\n", loops, axis_err_max);
+}
+
+int main(void)
+{
+    gen_input();
+
+    /* 节拍序号从接近回绕处开始，录制和回放都跨过32位回绕 */
+    test_record(0xFFFFFFFFu - TEST_TICKS / 2);
+    test_play(0xFFFFFFFFu - TEST_TICKS / 3, 1);
+    test_play(12345, 2);
+
+    printf("macro_test: %s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
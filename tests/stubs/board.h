@@ -0,0 +1,74 @@
+/**
+ * @file board.h
+ * @brief 主机测试用板级外设桩
+ * @details GPIO、DWT寄存器为普通内存；CMSIS DSP内联函数按Armv8-M架构手册的语义用C实现，
+ *          使DSP扩展路径可以在主机上编译并与标量参考实现逐位比对
+ */
+
+#ifndef __STUB_BOARD_H__
+#define __STUB_BOARD_H__
+
+#include <stdint.h>
+
+/* ================ 外设寄存器 ================ */
+
+typedef struct {
+    volatile uint32_t PDOR, PSOR, PCOR, PTOR, PDIR, PDDR;
+} GPIO_Type;
+
+typedef struct {
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+static GPIO_Type stub_gpio2 __attribute__((unused)), stub_gpio3 __attribute__((unused));
+static DWT_Type stub_dwt __attribute__((unused));
+
+#define GPIO2   (&stub_gpio2)
+#define GPIO3   (&stub_gpio3)
+#define DWT     (&stub_dwt)
+
+#define __DMB() __sync_synchronize()
+
+/* ================ CMSIS DSP内联函数 ================ */
+
+static inline int32_t stub_ssat(int32_t v, uint32_t bits)
+{
+    int32_t max = (int32_t)((1u << (bits - 1)) - 1);
+    int32_t min = -max - 1;
+
+    return v > max ? max : (v < min ? min : v);
+}
+
+static inline uint32_t stub_pack16(int32_t lo, int32_t hi)
+{
+    return (uint32_t)(uint16_t)lo | ((uint32_t)(uint16_t)hi << 16);
+}
+
+#define STUB_LO(x)  ((int32_t)(int16_t)(x))
+#define STUB_HI(x)  ((int32_t)(int16_t)((x) >> 16))
+
+/* 两对半字相乘后相加 */
+static inline uint32_t __SMUAD(uint32_t x, uint32_t y)
+{
+    return (uint32_t)(STUB_LO(x) * STUB_LO(y)) + (uint32_t)(STUB_HI(x) * STUB_HI(y));
+}
+
+/* 两路饱和减法 */
+static inline uint32_t __QSUB16(uint32_t x, uint32_t y)
+{
+    return stub_pack16(stub_ssat(STUB_LO(x) - STUB_LO(y), 16), stub_ssat(STUB_HI(x) - STUB_HI(y), 16));
+}
+
+/* 两路饱和加法 */
+static inline uint32_t __QADD16(uint32_t x, uint32_t y)
+{
+    return stub_pack16(stub_ssat(STUB_LO(x) + STUB_LO(y), 16), stub_ssat(STUB_HI(x) + STUB_HI(y), 16));
+}
+
+/* 两路饱和到bits位有符号数 */
+#define __SSAT16(x, bits)   stub_pack16(stub_ssat(STUB_LO(x), (bits)), stub_ssat(STUB_HI(x), (bits)))
+
+/* 低半字取自x，高半字取自y左移sh位 */
+#define __PKHBT(x, y, sh)   (((uint32_t)(x) & 0x0000FFFFu) | (((uint32_t)(y) << (sh)) & 0xFFFF0000u))
+
+#endif /* __STUB_BOARD_H__ */
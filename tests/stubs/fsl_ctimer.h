@@ -0,0 +1,57 @@
+/**
+ * @file fsl_ctimer.h
+ * @brief 主机测试用CTIMER和时钟驱动桩，定时器不运行
+ */
+
+#ifndef __STUB_FSL_CTIMER_H__
+#define __STUB_FSL_CTIMER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct { int dummy; } CTIMER_Type;
+typedef void (*ctimer_callback_t)(uint32_t flags);
+
+typedef struct { int dummy; } ctimer_config_t;
+
+typedef struct {
+    uint32_t matchValue;
+    bool enableCounterReset;
+    bool enableCounterStop;
+    int outControl;
+    bool outPinInitState;
+    bool enableInterrupt;
+} ctimer_match_config_t;
+
+enum { kCTIMER_Match_0 = 0, kCTIMER_Match_1, kCTIMER_Match_2, kCTIMER_Match_3 };
+enum { kCTIMER_Output_NoAction = 0, kCTIMER_Output_Toggle };
+enum { kCTIMER_SingleCallback = 0, kCTIMER_MultipleCallback };
+enum { kCLOCK_DivCTIMER0 = 0, kCLOCK_DivCTIMER1, kCLOCK_DivCTIMER2 };
+enum { kFRO_HF_to_CTIMER0 = 0, kFRO_HF_to_CTIMER1, kFRO_HF_to_CTIMER2 };
+
+static CTIMER_Type stub_ctimer[3] __attribute__((unused));
+#define CTIMER0 (&stub_ctimer[0])
+#define CTIMER1 (&stub_ctimer[1])
+#define CTIMER2 (&stub_ctimer[2])
+
+static inline void CLOCK_SetClockDiv(int div, uint32_t value) { (void)div; (void)value; }
+static inline void CLOCK_AttachClk(int clk) { (void)clk; }
+static inline uint32_t CLOCK_GetCTimerClkFreq(uint32_t id) { (void)id; return 48000000u; }
+
+static inline void CTIMER_GetDefaultConfig(ctimer_config_t *config) { (void)config; }
+static inline void CTIMER_Init(CTIMER_Type *base, const ctimer_config_t *config) { (void)base; (void)config; }
+static inline void CTIMER_Reset(CTIMER_Type *base) { (void)base; }
+static inline void CTIMER_StartTimer(CTIMER_Type *base) { (void)base; }
+static inline void CTIMER_StopTimer(CTIMER_Type *base) { (void)base; }
+
+static inline void CTIMER_SetupMatch(CTIMER_Type *base, int match, const ctimer_match_config_t *config)
+{
+    (void)base; (void)match; (void)config;
+}
+
+static inline void CTIMER_RegisterCallBack(CTIMER_Type *base, ctimer_callback_t *cb, int type)
+{
+    (void)base; (void)cb; (void)type;
+}
+
+#endif /* __STUB_FSL_CTIMER_H__ */
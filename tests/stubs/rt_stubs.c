@@ -0,0 +1,33 @@
+/**
+ * @file rt_stubs.c
+ * @brief 主机测试用内核函数和时间戳实现
+ */
+
+#include <rtthread.h>
+#include <stdarg.h>
+#include "timestamp.h"
+
+/* 测试可直接设置的微秒时间 */
+rt_uint32_t stub_time_us = 0;
+
+int rt_kprintf(const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vprintf(fmt, ap);
+    va_end(ap);
+
+    return n;
+}
+
+rt_uint32_t ts_us(void)
+{
+    return stub_time_us;
+}
+
+rt_uint32_t ts_cycles_to_us(rt_uint32_t cycles)
+{
+    return cycles;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file rtdevice.h
+ * @brief 主机测试用PIN设备接口桩，rt_pin_xxx由各测试实现
+ */
+
+#ifndef __STUB_RTDEVICE_H__
+#define __STUB_RTDEVICE_H__
+
+#include <rtthread.h>
+#include <rthw.h>
+
+#define PIN_LOW                 0x00
+#define PIN_HIGH                0x01
+
+#define PIN_MODE_OUTPUT         0x00
+#define PIN_MODE_INPUT          0x01
+#define PIN_MODE_INPUT_PULLUP   0x02
+#define PIN_MODE_INPUT_PULLDOWN 0x03
+
+#define PIN_IRQ_MODE_RISING     0x00
+#define PIN_IRQ_MODE_FALLING    0x01
+
+#define PIN_IRQ_DISABLE         0x00
+#define PIN_IRQ_ENABLE          0x01
+
+void rt_pin_mode(rt_base_t pin, rt_uint8_t mode);
+void rt_pin_write(rt_base_t pin, rt_uint8_t value);
+rt_int8_t rt_pin_read(rt_base_t pin);
+rt_err_t rt_pin_attach_irq(rt_base_t pin, rt_uint8_t mode, void (*hdr)(void *args), void *args);
+rt_err_t rt_pin_irq_enable(rt_base_t pin, rt_uint32_t enabled);
+
+#endif /* __STUB_RTDEVICE_H__ */
@@ -0,0 +1,14 @@
+/**
+ * @file rthw.h
+ * @brief 主机测试用中断开关桩
+ */
+
+#ifndef __STUB_RTHW_H__
+#define __STUB_RTHW_H__
+
+#include <rtthread.h>
+
+rt_inline rt_base_t rt_hw_interrupt_disable(void) { return 0; }
+rt_inline void rt_hw_interrupt_enable(rt_base_t level) { (void)level; }
+
+#endif /* __STUB_RTHW_H__ */
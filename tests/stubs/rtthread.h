@@ -0,0 +1,109 @@
+/**
+ * @file rtthread.h
+ * @brief 主机测试用RT-Thread内核接口桩
+ * @details 只提供applications下被测模块用到的类型和函数，中断、线程相关接口为空操作
+ */
+
+#ifndef __STUB_RTTHREAD_H__
+#define __STUB_RTTHREAD_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+typedef int8_t      rt_int8_t;
+typedef int16_t     rt_int16_t;
+typedef int32_t     rt_int32_t;
+typedef uint8_t     rt_uint8_t;
+typedef uint16_t    rt_uint16_t;
+typedef uint32_t    rt_uint32_t;
+typedef int         rt_bool_t;
+typedef long        rt_base_t;
+typedef long        rt_err_t;
+typedef uint32_t    rt_tick_t;
+typedef size_t      rt_size_t;
+
+#define RT_TRUE     1
+#define RT_FALSE    0
+#define RT_NULL     NULL
+
+#define RT_EOK      0
+#define RT_ERROR    1
+#define RT_ETIMEOUT 2
+#define RT_EFULL    3
+#define RT_EEMPTY   4
+#define RT_ENOMEM   5
+#define RT_ENOSYS   6
+#define RT_EBUSY    7
+#define RT_EIO      8
+#define RT_EINTR    9
+#define RT_EINVAL   10
+
+#define RT_WAITING_FOREVER  -1
+#define RT_WAITING_NO       0
+
+#define rt_inline   static inline
+
+/* 互斥量/信号量: 单线程测试中只记录状态 */
+struct rt_mutex { int locked; };
+typedef struct rt_mutex *rt_mutex_t;
+struct rt_semaphore { int value; };
+typedef struct rt_semaphore *rt_sem_t;
+
+#define RT_IPC_FLAG_FIFO    0x00
+#define RT_IPC_FLAG_PRIO    0x01
+
+rt_inline rt_err_t rt_mutex_init(rt_mutex_t m, const char *name, rt_uint8_t flag)
+{
+    (void)name; (void)flag;
+    m->locked = 0;
+    return RT_EOK;
+}
+
+rt_inline rt_err_t rt_mutex_take(rt_mutex_t m, rt_int32_t timeout)
+{
+    if (m->locked)
+        return (timeout == RT_WAITING_NO) ? -RT_ETIMEOUT : -RT_ERROR;
+    m->locked = 1;
+    return RT_EOK;
+}
+
+rt_inline rt_err_t rt_mutex_release(rt_mutex_t m)
+{
+    m->locked = 0;
+    return RT_EOK;
+}
+
+rt_inline rt_err_t rt_sem_release(rt_sem_t s)
+{
+    s->value++;
+    return RT_EOK;
+}
+
+/* 中断和延时 */
+rt_inline void rt_interrupt_enter(void) {}
+rt_inline void rt_interrupt_leave(void) {}
+rt_inline void rt_hw_us_delay(rt_uint32_t us) { (void)us; }
+rt_inline rt_err_t rt_thread_mdelay(rt_int32_t ms) { (void)ms; return RT_EOK; }
+
+/* 字符串与输出 */
+#define rt_memcmp   memcmp
+#define rt_memcpy   memcpy
+#define rt_memset   memset
+#define rt_strcmp   strcmp
+#define rt_snprintf snprintf
+
+int rt_kprintf(const char *fmt, ...);
+
+/*
+ * 自动初始化和msh命令: 生成一个指向函数的全局指针，
+ * 测试通过 stub_init_<fn>() / stub_msh_<cmd>(argc, argv) 调用模块内的静态函数
+ */
+#define INIT_BOARD_EXPORT(fn)   int (*const stub_init_##fn)(void) = fn
+#define INIT_DEVICE_EXPORT(fn)  int (*const stub_init_##fn)(void) = fn
+#define INIT_ENV_EXPORT(fn)     int (*const stub_init_##fn)(void) = fn
+#define INIT_APP_EXPORT(fn)     int (*const stub_init_##fn)(void) = fn
+#define MSH_CMD_EXPORT(cmd, desc) int (*const stub_msh_##cmd)(int, char **) = cmd
+
+#endif /* __STUB_RTTHREAD_H__ */
@@ -0,0 +1,12 @@
+/**
+ * @file usbd_core.h
+ * @brief 主机测试用CherryUSB设备栈桩，只为编译包含usb_app.h的模块
+ */
+
+#ifndef __STUB_USBD_CORE_H__
+#define __STUB_USBD_CORE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#endif /* __STUB_USBD_CORE_H__ */
@@ -0,0 +1,11 @@
+/**
+ * @file usbd_hid.h
+ * @brief 主机测试用CherryUSB HID类桩
+ */
+
+#ifndef __STUB_USBD_HID_H__
+#define __STUB_USBD_HID_H__
+
+#include "usbd_core.h"
+
+#endif /* __STUB_USBD_HID_H__ */
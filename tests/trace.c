@@ -0,0 +1,298 @@
+/**
+ * @file trace.c
+ * @brief 读写capture导出的原始采集数据
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "trace.h"
+
+#define TRACE_FRAMES_PER_RECORD  4      /* 与固件DMA半缓冲一致 */
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+/* 在数据中查找头部魔数 */
+static const uint8_t *find_magic(const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i + sizeof(capture_header_t) <= size; i++)
+    {
+        if (get_u32(data + i) == CAPTURE_MAGIC)
+            return data + i;
+    }
+    return NULL;
+}
+
+/* 把hex文本中只含十六进制字符的行解码为字节，其余行(命令回显等)跳过 */
+static size_t hex_decode(const char *text, size_t size, uint8_t *out)
+{
+    size_t n = 0, i = 0;
+
+    while (i < size)
+    {
+        size_t start = i, end;
+        int hex = 1;
+
+        while (i < size && text[i] != '\n')
+            i++;
+        end = i++;
+        while (end > start && isspace((unsigned char)text[end - 1]))
+            end--;
+
+        for (size_t k = start; k < end; k++)
+            hex &= isxdigit((unsigned char)text[k]) != 0;
+        if (!hex || end == start || ((end - start) & 1))
+            continue;
+
+        for (size_t k = start; k < end; k += 2)
+        {
+            char byte[3] = {text[k], text[k + 1], 0};
+            out[n++] = (uint8_t)strtoul(byte, NULL, 16);
+        }
+    }
+
+    return n;
+}
+
+static int parse(const uint8_t *p, size_t avail, trace_t *trace)
+{
+    const capture_header_t *hdr = (const capture_header_t *)p;
+    const uint8_t *rec, *end;
+    uint32_t sum = 0, t = 0;
+    size_t frame_cap = 1024, key_cap = 1024;
+
+    memcpy(&trace->hdr, hdr, sizeof(trace->hdr));
+    if (trace->hdr.version != CAPTURE_VERSION || trace->hdr.header_size != sizeof(capture_header_t) ||
+        sizeof(capture_header_t) + (size_t)trace->hdr.payload_size > avail)
+    {
+        fprintf(stderr, "trace: bad header\n");
+        return -1;
+    }
+
+    rec = p + sizeof(capture_header_t);
+    end = rec + trace->hdr.payload_size;
+    for (const uint8_t *q = rec; q < end; q++)
+        sum += *q;
+    if (sum != trace->hdr.checksum)
+    {
+        fprintf(stderr, "trace: checksum mismatch\n");
+        return -1;
+    }
+
+    trace->frames = malloc(frame_cap * sizeof(trace_frame_t));
+    trace->keys = malloc(key_cap * sizeof(trace_key_t));
+    trace->frame_count = trace->key_count = 0;
+
+    while (rec + 3 <= end)
+    {
+        uint8_t tag = rec[0];
+
+        t += get_u16(rec + 1);
+        rec += 3;
+
+        if (tag == CAPTURE_TAG_TIME && rec + 4 <= end)
+        {
+            t = get_u32(rec) - trace->hdr.start_us;
+            rec += 4;
+        }
+        else if (tag == CAPTURE_TAG_KEY && rec + 2 <= end)
+        {
+            if (trace->key_count == key_cap)
+                trace->keys = realloc(trace->keys, (key_cap *= 2) * sizeof(trace_key_t));
+            trace->keys[trace->key_count].time_us = t;
+            trace->keys[trace->key_count].raw = get_u16(rec);
+            trace->key_count++;
+            rec += 2;
+        }
+        else if (tag == CAPTURE_TAG_ADC && rec + 1 <= end && rec + 1 + rec[0] * TRACE_AXES * 2 <= end)
+        {
+            uint32_t count = rec[0];
+            uint32_t period = trace->hdr.adc_rate_hz ? 1000000u / trace->hdr.adc_rate_hz : 0;
+
+            rec++;
+            for (uint32_t f = 0; f < count; f++)
+            {
+                trace_frame_t *fr;
+
+                if (trace->frame_count == frame_cap)
+                    trace->frames = realloc(trace->frames, (frame_cap *= 2) * sizeof(trace_frame_t));
+                fr = &trace->frames[trace->frame_count++];
+                fr->time_us = t - (count - 1 - f) * period;
+                for (int a = 0; a < TRACE_AXES; a++)
+                    fr->v[a] = get_u16(rec + (f * TRACE_AXES + a) * 2);
+            }
+            rec += count * TRACE_AXES * 2;
+        }
+        else
+        {
+            fprintf(stderr, "trace: bad record tag 0x%02x at offset %ld\n", tag,
+                    (long)(rec - 3 - (p + sizeof(capture_header_t))));
+            trace_free(trace);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int trace_load(const char *path, trace_t *trace)
+{
+    FILE *f = fopen(path, "rb");
+    uint8_t *data, *hex = NULL;
+    const uint8_t *p;
+    long size;
+    int ret = -1;
+
+    memset(trace, 0, sizeof(*trace));
+    if (f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = malloc((size_t)size + 1);
+    if (fread(data, 1, (size_t)size, f) != (size_t)size)
+        size = 0;
+    fclose(f);
+
+    p = find_magic(data, (size_t)size);
+    if (p != NULL)
+    {
+        ret = parse(p, (size_t)(data + size - p), trace);
+    }
+    else
+    {
+        size_t n;
+
+        hex = malloc((size_t)size / 2 + 1);
+        n = hex_decode((const char *)data, (size_t)size, hex);
+        p = find_magic(hex, n);
+        if (p != NULL)
+            ret = parse(p, (size_t)(hex + n - p), trace);
+        else
+            fprintf(stderr, "%s: no capture header found\n", path);
+    }
+
+    free(hex);
+    free(data);
+    return ret;
+}
+
+void trace_free(trace_t *trace)
+{
+    free(trace->frames);
+    free(trace->keys);
+    trace->frames = NULL;
+    trace->keys = NULL;
+    trace->frame_count = trace->key_count = 0;
+}
+
+/* ================ 写出 ================ */
+
+typedef struct {
+    FILE *f;
+    uint32_t sum;
+    uint32_t size;
+    uint32_t last_us;
+} trace_writer_t;
+
+static void put(trace_writer_t *w, const void *data, uint32_t len)
+{
+    const uint8_t *p = data;
+
+    for (uint32_t i = 0; i < len; i++)
+        w->sum += p[i];
+    w->size += len;
+    fwrite(data, 1, len, w->f);
+}
+
+/* 写记录头，间隔超过16位时先写绝对时间 */
+static void put_tag(trace_writer_t *w, const trace_t *trace, uint8_t tag, uint32_t t)
+{
+    uint32_t dt = t - w->last_us;
+    uint8_t b[7];
+
+    if (dt > 0xFFFF)
+    {
+        uint32_t abs_us = trace->hdr.start_us + t;
+
+        b[0] = CAPTURE_TAG_TIME;
+        b[1] = b[2] = 0;
+        memcpy(&b[3], &abs_us, 4);
+        put(w, b, 7);
+        dt = 0;
+    }
+
+    b[0] = tag;
+    b[1] = (uint8_t)dt;
+    b[2] = (uint8_t)(dt >> 8);
+    put(w, b, 3);
+    w->last_us = t;
+}
+
+int trace_save(const char *path, const trace_t *trace)
+{
+    trace_writer_t w = {0};
+    capture_header_t hdr = trace->hdr;
+    uint32_t f = 0, k = 0;
+
+    w.f = fopen(path, "wb");
+    if (w.f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+
+    /* 先占位，写完记录后回填长度和校验和 */
+    fwrite(&hdr, sizeof(hdr), 1, w.f);
+
+    while (f < trace->frame_count || k < trace->key_count)
+    {
+        uint32_t n = trace->frame_count - f;
+        uint32_t adc_t;
+
+        if (n > TRACE_FRAMES_PER_RECORD)
+            n = TRACE_FRAMES_PER_RECORD;
+        adc_t = n ? trace->frames[f + n - 1].time_us : UINT32_MAX;
+
+        if (k < trace->key_count && trace->keys[k].time_us <= adc_t)
+        {
+            put_tag(&w, trace, CAPTURE_TAG_KEY, trace->keys[k].time_us);
+            put(&w, &trace->keys[k].raw, 2);
+            k++;
+        }
+        else
+        {
+            uint8_t count = (uint8_t)n;
+
+            put_tag(&w, trace, CAPTURE_TAG_ADC, adc_t);
+            put(&w, &count, 1);
+            for (uint32_t i = 0; i < n; i++)
+                put(&w, trace->frames[f + i].v, TRACE_AXES * 2);
+            f += n;
+        }
+    }
+
+    hdr.magic = CAPTURE_MAGIC;
+    hdr.version = CAPTURE_VERSION;
+    hdr.header_size = sizeof(capture_header_t);
+    hdr.payload_size = w.size;
+    hdr.checksum = w.sum;
+    fseek(w.f, 0, SEEK_SET);
+    fwrite(&hdr, sizeof(hdr), 1, w.f);
+    fclose(w.f);
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file trace.h
+ * @brief 读写capture导出的原始采集数据(格式见applications/capture.h)
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+#include "capture.h"
+
+#define TRACE_AXES  4
+
+/* 一帧摇杆原始值 */
+typedef struct {
+    uint32_t time_us;           /* 相对采集开始的时间 */
+    uint16_t v[TRACE_AXES];     /* LX LY RX RY */
+} trace_frame_t;
+
+/* 一次矩阵扫描 */
+typedef struct {
+    uint32_t time_us;
+    uint16_t raw;
+} trace_key_t;
+
+typedef struct {
+    capture_header_t hdr;
+    trace_frame_t *frames;
+    uint32_t frame_count;
+    trace_key_t *keys;
+    uint32_t key_count;
+} trace_t;
+
+/**
+ * @brief 读取采集文件: 二进制导出(可带控制台输出的前后文字)或capture dump hex文本
+ * @return 0成功，失败时打印原因并返回-1
+ */
+int trace_load(const char *path, trace_t *trace);
+
+/**
+ * @brief 释放trace_load分配的内存
+ */
+void trace_free(trace_t *trace);
+
+/**
+ * @brief 按capture格式写出采集文件，ADC记录每条最多4帧
+ * @return 0成功
+ */
+int trace_save(const char *path, const trace_t *trace);
+
+#endif /* __TRACE_H__ */